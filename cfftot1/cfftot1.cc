@@ -21,6 +21,7 @@
 #include <lcdf/error.hh>
 #include "maket1font.hh"
 #include <efont/cff.hh>
+#include <efont/cffw.hh>
 #include <efont/otf.hh>
 #include <stdlib.h>
 #include <string.h>
@@ -45,22 +46,33 @@ using namespace Efont;
 #define PFA_OPT         305
 #define OUTPUT_OPT      306
 #define NAME_OPT        307
+#define SUBRS_OPT       308
+#define CFF_OPT         309
+#define MAKE_OTF_OPT    310
+#define SUBSET_OPT      311
 
 const Clp_Option options[] = {
     { "ascii", 'a', PFA_OPT, 0, 0 },
     { "binary", 'b', PFB_OPT, 0, 0 },
+    { "cff", 0, CFF_OPT, 0, 0 },
     { "help", 'h', HELP_OPT, 0, 0 },
+    { "make-otf", 0, MAKE_OTF_OPT, 0, 0 },
     { "name", 'n', NAME_OPT, Clp_ValString, 0 },
     { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
     { "pfa", 'a', PFA_OPT, 0, 0 },
     { "pfb", 'b', PFB_OPT, 0, 0 },
     { "quiet", 'q', QUIET_OPT, 0, Clp_Negate },
+    { "subroutinize", 0, SUBRS_OPT, 0, Clp_Negate },
+    { "subset", 0, SUBSET_OPT, Clp_ValString, 0 },
     { "version", 'v', VERSION_OPT, 0, 0 },
 };
 
 
 static const char *program_name;
 static bool binary = true;
+static enum { out_type1, out_cff, out_otf } output_format = out_type1;
+static Vector<PermString> subset_glyphs;
+static bool subroutinize = true;
 
 
 void
@@ -92,8 +104,12 @@ Usage: %s [OPTIONS] [FONTFILE [OUTPUTFILE]]\n\
 Options:\n\
   -a, --pfa                    Output PFA font.\n\
   -b, --pfb                    Output PFB font. This is the default.\n\
+      --cff                    Output a bare CFF font.\n\
+      --make-otf               Output an OpenType/CFF font.\n\
+      --subset=GLYPHS          Output only GLYPHS (with --cff or --make-otf).\n\
   -n, --name=NAME              Select font NAME from CFF.\n\
   -o, --output=FILE            Write output to FILE.\n\
+      --no-subroutinize        Do not factor repeated code into subroutines.\n\
   -q, --quiet                  Do not generate any error messages.\n\
   -h, --help                   Print this message and exit.\n\
   -v, --version                Print version number and exit.\n\
@@ -104,6 +120,38 @@ Report bugs to <ekohler@gmail.com>.\n", program_name);
 
 // MAIN
 
+static void
+do_cff_file(Cff::FontParent *fp, const String &otf_data, const char *outfn,
+            ErrorHandler *errh)
+{
+    CffWriter writer(fp, errh);
+    writer.set_subroutinize(subroutinize);
+    for (PermString *g = subset_glyphs.begin(); g != subset_glyphs.end(); ++g)
+        if (!writer.add_glyph(*g))
+            errh->warning("glyph %<%s%> not in font", g->c_str());
+    String out = writer.write();
+    if (!out)
+        return;
+
+    if (output_format == out_otf) {
+        OpenType::Font otf(otf_data, errh);
+        out = CffWriter::make_otf(otf, out, writer.glyphs(), errh).data_string();
+    }
+
+    FILE *f;
+    if (!outfn || strcmp(outfn, "-") == 0) {
+        f = stdout;
+        outfn = "<stdout>";
+    } else if (!(f = fopen(outfn, "wb")))
+        errh->fatal("%s: %s", outfn, strerror(errno));
+#if defined(_MSDOS) || defined(_WIN32)
+    _setmode(_fileno(f), _O_BINARY);
+#endif
+    fwrite(out.data(), 1, out.length(), f);
+    if (f != stdout)
+        fclose(f);
+}
+
 static void
 do_file(const char *infn, const char *outfn, PermString name, ErrorHandler *errh)
 {
@@ -145,14 +193,22 @@ do_file(const char *infn, const char *outfn, PermString name, ErrorHandler *errh
     cerrh.set_indent(0);
     String data = sa.take_string();
     unsigned units_per_em = 0;
+    String otf_data;
     if (c == 'O') {
         Efont::OpenType::Font font(data, &cerrh);
+        otf_data = data;
         data = font.table("CFF");
         units_per_em = font.units_per_em();
-    }
+    } else if (output_format == out_otf)
+        errh->fatal("%s: %<--make-otf%> requires OpenType input", infn);
 
     Cff *cff = new Cff(data, units_per_em, &cerrh);
     Cff::FontParent *fp = cff->font(name, &cerrh);
+    if (output_format != out_type1) {
+        if (errh->nerrors() == 0)
+            do_cff_file(fp, otf_data, outfn, &cerrh);
+        return;
+    }
     if (errh->nerrors() == 0
         && !(font = dynamic_cast<Cff::Font *>(fp)))
         errh->fatal("%s: CID-keyed fonts not supported", infn);
@@ -160,7 +216,7 @@ do_file(const char *infn, const char *outfn, PermString name, ErrorHandler *errh
     if (errh->nerrors() > 0)
         return;
 
-    Type1Font *font1 = create_type1_font(font, &cerrh);
+    Type1Font *font1 = create_type1_font(font, subroutinize, &cerrh);
 
     if (!outfn || strcmp(outfn, "-") == 0) {
         f = stdout;
@@ -201,10 +257,12 @@ main(int argc, char *argv[])
 
           case PFA_OPT:
             binary = false;
+            output_format = out_type1;
             break;
 
           case PFB_OPT:
             binary = true;
+            output_format = out_type1;
             break;
 
           case NAME_OPT:
@@ -213,6 +271,30 @@ main(int argc, char *argv[])
             font_name = clp->vstr;
             break;
 
+          case SUBRS_OPT:
+            subroutinize = !clp->negated;
+            break;
+
+          case CFF_OPT:
+            output_format = out_cff;
+            break;
+
+          case MAKE_OTF_OPT:
+            output_format = out_otf;
+            break;
+
+          case SUBSET_OPT:
+            for (const char *s = clp->vstr; *s; ) {
+                while (*s == ',' || isspace((unsigned char) *s))
+                    ++s;
+                const char *start = s;
+                while (*s && *s != ',' && !isspace((unsigned char) *s))
+                    ++s;
+                if (s > start)
+                    subset_glyphs.push_back(PermString(start, s - start));
+            }
+            break;
+
           case QUIET_OPT:
             if (clp->negated)
                 errh = ErrorHandler::default_handler();
@@ -264,6 +346,8 @@ particular purpose.\n");
     }
 
   done:
+    if (subset_glyphs.size() && output_format == out_type1)
+        usage_error(errh, "%<--subset%> requires %<--cff%> or %<--make-otf%>");
     do_file(input_file, output_file, font_name, errh);
 
     return (errh->nerrors() == 0 ? 0 : 1);
@@ -22,6 +22,7 @@
 #include <efont/t1font.hh>
 #include <efont/t1item.hh>
 #include <efont/t1unparser.hh>
+#include <efont/t1subrize.hh>
 
 using namespace Efont;
 
@@ -510,7 +511,7 @@ add_delta_def(Type1Font* output, int dict, PermString name, const Cff::Font* fon
 }
 
 Type1Font *
-create_type1_font(Cff::Font *font, ErrorHandler *errh)
+create_type1_font(Cff::Font *font, bool subroutinize, ErrorHandler *errh)
 {
     String version = font->dict_string(Cff::oVersion);
     Type1Font *output = Type1Font::skeleton_make(font->font_name(), version);
@@ -600,6 +601,12 @@ create_type1_font(Cff::Font *font, ErrorHandler *errh)
     MakeType1CharstringInterp maker(5);
     maker.run(font, output, " |-", errh);
 
+    // factor out repeated code
+    if (subroutinize) {
+        Type1Subroutinizer subrizer(output);
+        subrizer.run();
+    }
+
     StringAccum::double_format = old_double_format;
     return output;
 }
@@ -25,6 +25,13 @@ class AfmParser { public:
     bool is(const char *, ...);
     bool isall(const char *, ...);
 
+    // Fast paths for the commonest lines. They return false, changing
+    // nothing, on any line they don't recognize; then use is()/isall().
+    bool is_char_metric(int &c, double &wx, PermString &n, double &llx,
+                        double &lly, double &urx, double &ury);
+    bool isall_kern_pair(const char *keyword, PermString &left,
+                         PermString &right, double &amount);
+
     inline bool next_line();
     void save_line()                    { _slurper.save_line(); }
     void skip_until(unsigned char);
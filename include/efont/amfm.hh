@@ -63,6 +63,9 @@ class AmfmMetrics { public:
 
     Metrics *interpolate(const Vector<double> &design,
                          const Vector<double> &weight, ErrorHandler *);
+    bool interpolate(const Vector<Vector<double> > &designs,
+                     const Vector<Vector<double> > &weights,
+                     Vector<Metrics *> &results, ErrorHandler *);
 
   private:
 
@@ -102,6 +105,7 @@ class AmfmMetrics { public:
     AmfmPrimaryFont *find_primary_font(const Vector<double> &design) const;
 
     Metrics *master(int, ErrorHandler *);
+    Metrics *new_instance(const Vector<double> &design, int master) const;
 
 };
 
@@ -6,6 +6,7 @@
 class ErrorHandler;
 namespace Efont {
 class Type1Encoding;
+class CffWriter;
 
 class Cff { public:
 
@@ -168,6 +169,8 @@ class Cff::Dict { public:
     Vector<double> _operands;
     int _error;
 
+    friend class CffWriter;
+
 };
 
 class Cff::Charset { public:
@@ -248,6 +251,7 @@ class Cff::FontParent : public CharstringProgram { public:
     friend class Cff::Font;
     friend class Cff::CIDFont;
     friend class Cff::ChildFont;
+    friend class CffWriter;
 
 };
 
@@ -290,6 +294,8 @@ class Cff::CIDFont : public Cff::FontParent { public:
 
     const Dict& dict_of(DictOperator) const;
 
+    friend class CffWriter;
+
 };
 
 class Cff::ChildFont : public Cff::FontParent { public:
@@ -337,6 +343,7 @@ class Cff::ChildFont : public Cff::FontParent { public:
     Charstring* charstring(const IndexIterator&, int) const;
 
     friend class Cff::Font;
+    friend class CffWriter;
 
 };
 
@@ -382,6 +389,8 @@ class Cff::Font : public Cff::ChildFont { public:
 
     inline const Dict& dict_of(DictOperator) const;
 
+    friend class CffWriter;
+
 };
 
 
@@ -0,0 +1,70 @@
+// -*- related-file-name: "../../libefont/cffw.cc" -*-
+#ifndef EFONT_CFFW_HH
+#define EFONT_CFFW_HH
+#include <efont/cff.hh>
+#include <efont/otf.hh>
+namespace Efont {
+
+// Writes a CFF containing a subset of a Cff::Font's or Cff::CIDFont's
+// glyphs. Charstrings are flattened (all subroutine calls expanded) and,
+// unless subroutinization is turned off, repeated code is factored into new
+// subroutines: into a Font DICT's local Subrs when only that Font DICT's
+// glyphs use it, and into the global Subrs otherwise. Only Type 2
+// charstrings are supported.
+
+class CffWriter { public:
+
+    CffWriter(Cff::FontParent *, ErrorHandler * = 0);
+
+    bool subroutinize() const                   { return _subroutinize; }
+    void set_subroutinize(bool s)               { _subroutinize = s; }
+
+    // Output glyphs appear in the order they were added, after .notdef.
+    // With no added glyphs, all glyphs are written.
+    bool add_glyph(int gid);
+    bool add_glyph(PermString name);
+    const Vector<int> &glyphs() const           { return _gids; }
+
+    String write();
+
+    // Wraps a CFF written for 'otf''s glyphs 'gids' into a minimal
+    // OpenType font, with hmtx, cmap and maxp restricted to those glyphs.
+    static OpenType::Font make_otf(const OpenType::Font &otf, const String &cff,
+                                   const Vector<int> &gids, ErrorHandler * = 0);
+
+  private:
+
+    Cff::FontParent *_font;
+    Cff::Font *_t1font;
+    Cff::CIDFont *_cidfont;
+    Cff *_cff;
+    ErrorHandler *_errh;
+    bool _subroutinize;
+
+    Vector<int> _gids;                          // output glyph -> input glyph
+    Vector<int> _gid_map;                       // input glyph -> output glyph
+    Vector<int> _fds;                           // output glyph -> output FD
+    Vector<const Cff::ChildFont *> _fd_fonts;   // output FD -> input FD
+
+    Vector<String> _charstrings;
+    Vector<Vector<String> > _local_subrs;       // per output FD
+    Vector<String> _global_subrs;
+
+    Vector<String> _strings;
+    HashMap<PermString, int> _string_map;
+
+    class Subroutinizer;
+
+    bool flatten(int gid, String &out);
+    void subroutinize_charstrings();
+    int sid(PermString);
+    int copy_sid(int sid);
+    void write_dict(StringAccum &sa, const Cff::Dict &dict, bool is_top);
+    void write_charset(StringAccum &sa);
+    void write_encoding(StringAccum &sa);
+    void write_fdselect(StringAccum &sa);
+
+};
+
+}
+#endif
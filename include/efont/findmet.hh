@@ -30,6 +30,11 @@ class MetricsFinder { public:
     virtual void record(Metrics *, PermString);
     virtual void record(AmfmMetrics *);
 
+    // Negative caching: a finder that returns true from is_missing() ends
+    // the search. record_missing() is called after every finder misses.
+    virtual bool is_missing(PermString, bool amfm) const;
+    virtual void record_missing(PermString, bool amfm);
+
   private:
 
     MetricsFinder *_next;
@@ -38,8 +43,13 @@ class MetricsFinder { public:
     MetricsFinder(const MetricsFinder &)                        { }
     MetricsFinder &operator=(const MetricsFinder &)     { return *this; }
 
+    void chain_changed();
+
   protected:
 
+    // Called on every finder in a chain when finders are added or removed.
+    virtual void finders_changed()      { }
+
     Metrics *try_metrics_file(const Filename &, MetricsFinder *, ErrorHandler *);
     AmfmMetrics *try_amfm_file(const Filename &, MetricsFinder *, ErrorHandler *);
 
@@ -56,6 +66,9 @@ class CacheMetricsFinder: public MetricsFinder { public:
     void record(Metrics *, PermString);
     void record(AmfmMetrics *);
 
+    bool is_missing(PermString, bool amfm) const;
+    void record_missing(PermString, bool amfm);
+
     void clear();
 
   private:
@@ -64,6 +77,10 @@ class CacheMetricsFinder: public MetricsFinder { public:
     Vector<Metrics *> _metrics;
     HashMap<PermString, int> _amfm_map;
     Vector<AmfmMetrics *> _amfm;
+    HashMap<PermString, int> _missing_metrics;
+    HashMap<PermString, int> _missing_amfm;
+
+    void finders_changed();
 
 };
 
@@ -77,6 +94,7 @@ class InstanceMetricsFinder: public MetricsFinder { public:
   private:
 
     bool _call_mmpfb;
+    HashMap<PermString, int> _mmpfb_tried;
 
     Metrics *find_metrics_instance(PermString, MetricsFinder *, ErrorHandler *);
 
@@ -107,6 +125,11 @@ class DirectoryMetricsFinder: public MetricsFinder { public:
   private:
 
     PermString _directory;
+    bool _listed;
+    bool _listing_ok;
+    HashMap<PermString, int> _files;
+
+    bool maybe_exists(PermString name, const char *suffix);
 
 };
 
@@ -0,0 +1,73 @@
+// -*- related-file-name: "../../libefont/fontindex.cc" -*-
+#ifndef EFONT_FONTINDEX_HH
+#define EFONT_FONTINDEX_HH
+#include <efont/otf.hh>
+#include <lcdf/hashmap.hh>
+#include <lcdf/vector.hh>
+#include <utility>
+class ErrorHandler;
+namespace Efont {
+
+// A persistent index of OpenType font metadata. Entries are keyed by
+// absolute file name; add_font() and refresh() reparse a font only when its
+// size or modification time has changed.
+class FontIndex { public:
+
+    FontIndex();
+
+    struct Entry {
+        String filename;
+        unsigned long long size;
+        unsigned long long mtime;
+        PermString postscript_name;
+        PermString family;
+        PermString style;
+        String version;
+        Vector<String> scripts;         // "latn", "latn.TRK", ...
+        Vector<OpenType::Tag> features; // sorted, over all scripts
+        double optical_min;             // 0 if unknown
+        double optical_max;
+        Vector<OpenType::Tag> tables;
+        Vector<uint32_t> table_checksums;
+    };
+
+    int size() const                    { return _entries.size(); }
+    const Entry &operator[](int i) const { return _entries[i]; }
+
+    bool read(const String &filename, ErrorHandler *errh = 0);
+    bool write(const String &filename, ErrorHandler *errh = 0) const;
+
+    bool add_font(const String &filename, ErrorHandler *errh = 0);
+    int refresh(ErrorHandler *errh = 0);
+
+    // Append the .otf and .ttf files under directory, recursively and in
+    // sorted order, to filenames.
+    static void find_fonts(const String &directory, Vector<String> &filenames, ErrorHandler *errh = 0);
+    static bool is_font_filename(const String &name);
+
+    // Set scripts to otf's language systems and features to its feature
+    // tags, over both GSUB and GPOS, sorted and without duplicates.
+    static void collect_layout(const OpenType::Font &otf, Vector<String> &scripts, Vector<OpenType::Tag> &features, ErrorHandler *errh = 0);
+
+    int find_postscript_name(PermString name) const;
+    void find_family(PermString family, Vector<int> &result) const;
+    void find_feature(OpenType::Tag feature, Vector<int> &result) const;
+
+  private:
+
+    Vector<Entry> _entries;
+    HashMap<String, int> _file_map;
+
+    mutable bool _sorted;
+    mutable Vector<std::pair<PermString, int> > _by_name;
+    mutable Vector<std::pair<PermString, int> > _by_family;
+    mutable Vector<std::pair<OpenType::Tag, int> > _by_feature;
+
+    bool parse_font(Entry &e, const String &data, ErrorHandler *errh);
+    void rebuild_file_map();
+    void sort() const;
+
+};
+
+}
+#endif
@@ -72,6 +72,12 @@ class Metrics { public:
     inline int add_kv(double d);
 
     void interpolate_dimens(const Metrics &, double, bool increment);
+    void interpolate_kerns(const Metrics &, double, bool increment);
+    static void interpolate_dimens(const Vector<const Metrics *> &masters,
+                                   const Vector<double> &weights,
+                                   const Vector<Metrics *> &instances);
+    void round_dimens(int precision);
+    void zero_small_kerns(double min_kern);
 
     // PAIR PROGRAM
 
@@ -115,6 +121,9 @@ class Metrics { public:
 
     unsigned _uses;
 
+    bool kerns_aligned(const Metrics &) const;
+    void matched_kerns(const Metrics &, Vector<double> &) const;
+
 };
 
 
@@ -70,6 +70,7 @@ class Font {
     static uint32_t checksum(const uint8_t *, const uint8_t *);
     static uint32_t checksum(const String &);
     static Font make(bool truetype, const Vector<Tag>& tags, const Vector<String>& data);
+    static String make_directory(bool truetype, const Vector<Tag>& tags, const Vector<String>& data, Vector<int>* order = 0);
 
     enum { HEADER_SIZE = 12, TABLE_DIR_ENTRY_SIZE = 16 };
 
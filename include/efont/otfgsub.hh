@@ -131,6 +131,7 @@ class Substitution { public:
 
     Substitution();
     Substitution(const Substitution &);
+    inline Substitution(Substitution &&);
 
     // single substitution
     Substitution(Glyph in, Glyph out);
@@ -149,6 +150,7 @@ class Substitution { public:
     ~Substitution();
 
     Substitution &operator=(const Substitution &);
+    Substitution &operator=(Substitution &&);
 
     bool context_in(const Coverage &) const;
     bool context_in(const GlyphSet &) const;
@@ -233,6 +235,7 @@ class Substitution { public:
     static void assign(Substitute &, uint8_t &, int, const Glyph *);
     static void assign(Substitute &, uint8_t &, const Coverage &);
     static void assign(Substitute &, uint8_t &, const Substitute &, uint8_t);
+    static inline void transfer(Substitute &, uint8_t &, Substitute &, uint8_t &);
     static void assign_append(Substitute &, uint8_t &, const Substitute &, uint8_t, const Substitute &, uint8_t);
     static void assign_append(Substitute &, uint8_t &, const Substitute &, uint8_t, Glyph);
     static bool substitute_in(const Substitute &, uint8_t, const Coverage &);
@@ -250,10 +253,30 @@ class Substitution { public:
 };
 
 inline Substitution::Substitution()
-    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_NONE), _right_is(T_NONE)
+    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_NONE), _right_is(T_NONE),
+      _alternate(false)
 {
 }
 
+inline void Substitution::transfer(Substitute &s, uint8_t &t, Substitute &os, uint8_t &ot)
+{
+    // only the member named by the tag is initialized
+    if (ot != T_NONE)
+        s = os;
+    t = ot;
+    ot = T_NONE;
+}
+
+inline Substitution::Substitution(Substitution &&o)
+    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_NONE), _right_is(T_NONE),
+      _alternate(o._alternate)
+{
+    transfer(_left, _left_is, o._left, o._left_is);
+    transfer(_in, _in_is, o._in, o._in_is);
+    transfer(_out, _out_is, o._out, o._out_is);
+    transfer(_right, _right_is, o._right, o._right_is);
+}
+
 /* Single 1: u16 format, offset coverage, u16 glyphdelta
    Single 2: u16 format, offset coverage, u16 count, glyph subst[]
    Multiple 1: u16 format, offset coverage, u16 count, offset sequence[];
@@ -59,13 +59,13 @@ class PairOp { public:
 
 class PairProgram { public:
 
-    PairProgram()                               : _reversed(false) { }
+    PairProgram()                               : _reversed(false), _frozen(false) { }
     PairProgram(const PairProgram &);
 
     void reserve_glyphs(int);
 
     PairOpIndex find_left(GlyphIndex gi) const  { return _left_map[gi]; }
-    PairOpIndex find(GlyphIndex leftgi, GlyphIndex rightgi) const;
+    PairOpIndex find_kern(GlyphIndex leftgi, GlyphIndex rightgi) const;
 
     int op_count() const                        { return _op.size(); }
     const PairOp &op(PairOpIndex i) const       { return _op[i]; }
@@ -78,14 +78,24 @@ class PairProgram { public:
     void unreverse();
     void optimize();
 
+    // Build a sorted per-left-glyph index for find_kern(); adding ops or
+    // unreversing discards it.
+    void freeze();
+    bool frozen() const                         { return _frozen; }
+
     void print() const;
 
   private:
 
     bool _reversed;
+    bool _frozen;
     Vector<PairOpIndex> _left_map;
     Vector<PairOp> _op;
 
+    Vector<int> _csr_first;
+    Vector<GlyphIndex> _csr_right;
+    Vector<PairOpIndex> _csr_op;
+
     inline const char *print_name(GlyphIndex) const;
 
     PairProgram &operator=(const PairProgram &) { assert(0); return *this; }
@@ -6,6 +6,7 @@
 #include <lcdf/string.hh>
 #include <lcdf/filename.hh>
 class Slurper;
+class CacheWriter;
 namespace Efont {
 class PsresDatabaseSection;
 
@@ -27,10 +28,16 @@ class PsresDatabase { public:
 
     HashMap<PermString, int> _section_map;
     Vector<PsresDatabaseSection*> _sections;
+    Vector<String> _source_files;
 
     PsresDatabaseSection* force_section(PermString);
     bool add_one_psres_file(Slurper&, bool override);
     void add_psres_directory(PermString);
+    void add_psres_path_directory(PermString);
+
+    static String cache_filename(PermString directory);
+    bool read_cache(const String& cache, PermString directory);
+    void write_cache(const String& cache, PermString directory) const;
 
 };
 
@@ -42,6 +49,9 @@ class PsresDatabaseSection { public:
 
     void add_psres_file_section(Slurper&, PermString, bool);
     void add_section(PsresDatabaseSection*, bool override);
+    void add_value(PermString key, PermString directory,
+                   const String& value, bool escaped);
+    void write_cache(CacheWriter&) const;
 
     const String& value(PermString key)         { return value(_map[key]); }
     inline const String& unescaped_value(PermString key) const;
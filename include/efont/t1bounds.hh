@@ -3,6 +3,7 @@
 #define EFONT_T1BOUNDS_HH
 #include <efont/t1interp.hh>
 #include <lcdf/transform.hh>
+#include <lcdf/hashmap.hh>
 namespace Efont {
 
 class CharstringBounds : public CharstringInterp { public:
@@ -38,6 +39,9 @@ class CharstringBounds : public CharstringInterp { public:
                        double bounds[4], double& width);
     static bool bounds(const Transform&, const CharstringContext&,
                        double bounds[4], double& width);
+    // cached in the program, keyed by glyph, transform, and weight vector
+    static bool bounds(const Transform&, const CharstringProgram*, int gid,
+                       double bounds[4], double& width);
 
   private:
 
@@ -58,6 +62,24 @@ class CharstringBounds : public CharstringInterp { public:
 
 };
 
+class CharstringBoundsCache { public:
+
+    CharstringBoundsCache()                     : _map(-1) { }
+
+    bool find(const Transform&, int gid, const Vector<double>& weight_vec,
+              double bounds[4], double& width, bool& ok) const;
+    void insert(const Transform&, int gid, const Vector<double>& weight_vec,
+                const double bounds[4], double width, bool ok);
+
+  private:
+
+    HashMap<String, int> _map;
+    Vector<double> _values;     // 6 per entry: bounds, width, ok
+
+    static String key(const Transform&, int gid, const Vector<double>&);
+
+};
+
 inline void CharstringBounds::xf_mark(const Point& p)
 {
     if (!KNOWN(_lb.x))
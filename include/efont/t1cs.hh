@@ -18,11 +18,12 @@ class CharstringProgram;
 class CharstringInterp;
 struct CharstringContext;
 class MultipleMasterSpace;
+class CharstringBoundsCache;
 class Type1Encoding;
 
 class Charstring { public:
 
-    Charstring()                                { }
+    Charstring()                                : _decoded_length(-1) { }
     virtual ~Charstring();
 
     virtual bool process(CharstringInterp&) const = 0;
@@ -126,6 +127,23 @@ class Charstring { public:
 
     static const char* const standard_encoding[256];
 
+    // Charstrings are decoded into Instructions the first time they're
+    // processed; later runs skip number decoding. An Instruction's op is a
+    // command or iInteger/iFixed; pos is its byte offset.
+    struct Instruction {
+        int32_t value;
+        uint16_t op;
+        uint16_t pos;
+    };
+    enum { iInteger = 0x200, iFixed = 0x201 };
+
+  protected:
+
+    mutable String _decoded;            // packed Instructions
+    mutable int _decoded_length;        // bytes covered by _decoded, or -1
+
+    inline void clear_decoded() const;
+
 };
 
 
@@ -158,6 +176,7 @@ class Type1Charstring : public Charstring { public:
     mutable int _key;
 
     void decrypt() const;
+    void decode() const;
 
 };
 
@@ -179,6 +198,8 @@ class Type2Charstring : public Charstring { public:
 
     String _s;
 
+    void decode() const;
+
 };
 
 
@@ -199,7 +220,7 @@ struct CharstringContext {
 class CharstringProgram { public:
 
     explicit CharstringProgram(unsigned units_per_em);
-    virtual ~CharstringProgram()                { }
+    virtual ~CharstringProgram();
 
     virtual PermString font_name() const        { return PermString(); }
     virtual void font_matrix(double[6]) const;
@@ -231,6 +252,12 @@ class CharstringProgram { public:
     inline CharstringContext glyph_context(int) const;
     inline CharstringContext glyph_context(PermString) const;
 
+    // Metrics for every glyph, in font units: advance widths, left side
+    // bearings, and bounding boxes (4 per glyph: xmin, ymin, xmax, ymax;
+    // zero for empty glyphs). Unreadable glyphs get UNKDOUBLE widths.
+    virtual void glyph_metrics(Vector<double>& widths, Vector<double>& lsbs,
+                               Vector<double>& bboxes) const;
+
     virtual bool is_mm() const                  { return mmspace() != 0; }
     virtual MultipleMasterSpace* mmspace() const        { return 0; }
     enum VectorType { VEC_WEIGHT = 0, VEC_NORM_DESIGN = 1, VEC_DESIGN = 2 };
@@ -240,10 +267,16 @@ class CharstringProgram { public:
 
     virtual double global_width_x(bool is_nominal) const;
 
+    CharstringBoundsCache* bounds_cache() const;
+
   private:
 
     bool _parent_program;
     uint16_t _units_per_em;
+    mutable CharstringBoundsCache* _bounds_cache;
+
+    CharstringProgram(const CharstringProgram&); // does not exist
+    CharstringProgram& operator=(const CharstringProgram&); // does not exist
 
 };
 
@@ -262,10 +295,17 @@ inline Type1Charstring::Type1Charstring(const String& s)
 {
 }
 
+inline void Charstring::clear_decoded() const
+{
+    _decoded = String();
+    _decoded_length = -1;
+}
+
 inline void Type1Charstring::assign(const String& s)
 {
     _s = s;
     _key = -1;
+    clear_decoded();
 }
 
 inline const uint8_t* Type1Charstring::data() const
@@ -90,6 +90,23 @@ class Type1PFBReader : public Type1Reader {
 
 };
 
+class Type1StringReader : public Type1Reader {
+
+    String _str;
+    int _pos;
+    bool _pfb;
+    bool _binary;
+    int _left;
+
+  public:
+
+    Type1StringReader(const String &);  // PFA or PFB data
+
+    int more_data(unsigned char *, int);
+    bool preserve_whitespace() const;
+
+};
+
 class Type1SubsetReader : public Type1Reader {
 
     Type1Reader *_reader;
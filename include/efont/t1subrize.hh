@@ -0,0 +1,125 @@
+// -*- related-file-name: "../../libefont/t1subrize.cc" -*-
+#ifndef EFONT_T1SUBRIZE_HH
+#define EFONT_T1SUBRIZE_HH
+#include <efont/t1font.hh>
+namespace Efont {
+
+// Factors byte sequences repeated across a set of glyph charstrings into
+// new subroutines. Subclasses split each charstring into commands (an
+// operator with its operands) and say which commands may move; repeats of
+// movable commands are found with a suffix array over the commands of all
+// glyphs and chosen greedily by the number of bytes they save. New
+// subroutines never call other subroutines.
+//
+// tokenize() and rewrite() touch only the glyphs in their range, so they
+// may run concurrently on disjoint ranges.
+
+class CharstringSubroutinizer { public:
+
+    CharstringSubroutinizer(int nglyphs);
+    virtual ~CharstringSubroutinizer()          { }
+
+    enum { max_subrs_limit = 65535 };
+
+    int max_subrs() const                       { return _max_subrs; }
+    void set_max_subrs(int n)                   { _max_subrs = n; }
+
+    int nglyphs() const                         { return _charstrings.size(); }
+    const String &charstring(int g) const       { return _charstrings[g]; }
+    void set_charstring(int g, const String &cs) { _charstrings[g] = cs; }
+
+    virtual void tokenize(int first_glyph, int last_glyph) = 0;
+    int choose_subrs();
+    void rewrite(int first_glyph, int last_glyph);
+
+    // subroutines found by choose_subrs(), in order of discovery; bodies
+    // do not include the final "return"
+    int nsubrs_added() const                    { return _new_subrs.size(); }
+    String subr_body(int i) const;
+    int subr_ncalls(int i) const                { return _new_subrs[i].ncalls; }
+    void subr_callers(Vector<Vector<int> > &callers) const;
+    void set_subr_call(int i, const String &call);
+
+    int bytes_saved() const                     { return _bytes_saved; }
+
+  protected:
+
+    // one Vector of command offsets per glyph, each encoded as
+    // (offset << 1) | movable, followed by (length << 1)
+    Vector<Vector<int> > _glyph_offsets;
+
+    // estimated size of the i'th new subroutine's call, and of the
+    // subroutine's other overhead
+    virtual int call_bytes(int i) const = 0;
+    virtual int subr_overhead() const = 0;
+
+  private:
+
+    struct Candidate {
+        int lb;
+        int rb;
+        int len;
+        int savings;
+    };
+
+    struct NewSubr {
+        int pos;                // first occurrence in _seq
+        int len;                // in commands
+        int ncalls;
+        String call;
+    };
+
+    Vector<String> _charstrings;
+    int _max_subrs;
+    int _bytes_saved;
+
+    // concatenated command sequence
+    Vector<int> _seq;
+    Vector<int> _seq_glyph;
+    Vector<int> _seq_offset;
+    Vector<int> _seq_bytes;     // prefix sums of command lengths
+    Vector<int> _glyph_start;
+
+    Vector<NewSubr> _new_subrs;
+    Vector<int> _replacement;   // per position: index into _new_subrs or -1
+
+    void build_sequence();
+    void suffix_array(Vector<int> &sa) const;
+    void lcp_array(const Vector<int> &sa, Vector<int> &lcp) const;
+    void find_candidates(const Vector<int> &sa, const Vector<int> &lcp,
+                         Vector<Candidate> &candidates) const;
+    inline int command_bytes(int pos, int len) const;
+
+    static bool candidate_cmp(const Candidate &, const Candidate &);
+
+};
+
+// Adds new Subrs to a Type 1 font. Only path and hint commands move;
+// hsbw, seac, endchar and (other)subr calls stay put. The most-called
+// subroutines get the shortest numbers.
+
+class Type1Subroutinizer : public CharstringSubroutinizer { public:
+
+    Type1Subroutinizer(Type1Font *);
+
+    int run();
+
+    void tokenize(int first_glyph, int last_glyph);
+
+  private:
+
+    Type1Font *_font;
+    int _first_subrno;
+
+    int call_bytes(int i) const;
+    int subr_overhead() const;
+
+};
+
+inline int CharstringSubroutinizer::command_bytes(int pos, int len) const
+{
+    return _seq_bytes[pos + len] - _seq_bytes[pos];
+}
+
+}
+#endif
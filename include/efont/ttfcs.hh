@@ -4,6 +4,7 @@
 #include <efont/t1cs.hh>
 #include <efont/otf.hh>
 #include <efont/otfdata.hh>
+#include <lcdf/point.hh>
 namespace Efont {
 
 class TrueTypeBoundsCharstringProgram : public CharstringProgram { public:
@@ -18,7 +19,10 @@ class TrueTypeBoundsCharstringProgram : public CharstringProgram { public:
     PermString glyph_name(int gi) const;
     void glyph_names(Vector<PermString> &) const;
 
-  private:
+    void glyph_metrics(Vector<double>& widths, Vector<double>& lsbs,
+                       Vector<double>& bboxes) const;
+
+  protected:
 
     const OpenType::Font *_otf;
     int _nglyphs;
@@ -28,6 +32,13 @@ class TrueTypeBoundsCharstringProgram : public CharstringProgram { public:
     OpenType::Data _glyf;
     OpenType::Data _hmtx;
     mutable Vector<Charstring*> _charstrings;
+
+    bool glyph_location(int gi, uint32_t& offset, uint32_t& end_offset) const;
+    bool glyph_header(int gi, int& ncontours, int bbox[4],
+                      int& advance_width, int& lsb) const;
+
+  private:
+
     mutable Vector<PermString> _glyph_names;
     mutable bool _got_glyph_names;
     mutable Vector<uint32_t> _unicodes;
@@ -35,6 +46,30 @@ class TrueTypeBoundsCharstringProgram : public CharstringProgram { public:
 
 };
 
+class TrueTypeCharstringProgram : public TrueTypeBoundsCharstringProgram { public:
+
+    TrueTypeCharstringProgram(const OpenType::Font *);
+
+    Charstring *glyph(int gi) const;
+
+    void glyph_metrics(Vector<double>& widths, Vector<double>& lsbs,
+                       Vector<double>& bboxes) const;
+
+  private:
+
+    struct Outline {
+        Vector<Point> points;
+        Vector<bool> on_curve;
+        Vector<int> contour_ends;
+    };
+
+    bool read_outline(int gi, Outline&, int depth) const;
+    bool read_simple(uint32_t offset, uint32_t end_offset, Outline&) const;
+    bool read_composite(uint32_t offset, uint32_t end_offset, Outline&,
+                        int depth) const;
+
+};
+
 }
 #endif
 
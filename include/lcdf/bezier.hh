@@ -31,6 +31,7 @@ class Bezier { public:
     inline double bb_top_x() const noexcept;
     inline double bb_bottom_x() const noexcept;
 
+    int extrema(double t[4]) const noexcept;
     void halve(Bezier &, Bezier &) const noexcept;
 
     inline void segmentize(Vector<Point> &) const;
@@ -0,0 +1,92 @@
+// -*- related-file-name: "../../liblcdf/cachefile.cc" -*-
+#ifndef LCDF_CACHEFILE_HH
+#define LCDF_CACHEFILE_HH
+#include <lcdf/straccum.hh>
+class ErrorHandler;
+
+/* Binary cache and index files. Numbers are 32-bit little-endian words
+   (64-bit values take two words); strings are a length word followed by
+   their bytes. A file stamp is a file's size and modification time. */
+
+class CacheWriter { public:
+
+    CacheWriter()                       { }
+
+    void put(uint32_t x);
+    void put64(unsigned long long x);
+    void put(const String &str);
+    bool put_file_stamp(const String &filename);
+
+    const StringAccum &data() const     { return _sa; }
+
+    bool write(const String &filename, bool create_directories, ErrorHandler *errh = 0) const;
+
+  private:
+
+    StringAccum _sa;
+
+};
+
+class CacheReader { public:
+
+    CacheReader()                       : _s(0), _end(0) { }
+
+    bool read(const String &filename, ErrorHandler *errh = 0);
+
+    bool get(uint32_t &x);
+    bool get(int &x);
+    bool get64(unsigned long long &x);
+    bool get(String &str);
+    bool get_count(uint32_t &n, uint32_t min_item_size);
+    bool check_file_stamp(const String &filename);
+
+    bool done() const                   { return _s == _end; }
+
+  private:
+
+    String _data;
+    const unsigned char *_s;
+    const unsigned char *_end;
+
+};
+
+String read_whole_file(const String &filename, ErrorHandler *errh = 0);
+
+// Return the name of a cache file for key in $XDG_CACHE_HOME/lcdf-typetools
+// (default ~/.cache/lcdf-typetools), or an empty string if caching is
+// disabled by a nonempty LCDF_TYPETOOLS_NOCACHE.
+String cache_filename(const char *prefix, const String &key);
+
+inline void CacheWriter::put(const String &str) {
+    put(str.length());
+    _sa << str;
+}
+
+inline void CacheWriter::put64(unsigned long long x) {
+    put((uint32_t) x);
+    put((uint32_t) (x >> 32));
+}
+
+inline bool CacheReader::get(int &x) {
+    uint32_t u;
+    if (!get(u))
+        return false;
+    x = (int) u;
+    return true;
+}
+
+// Read a count of items that each take at least min_item_size bytes, failing
+// if the rest of the file is too short to hold them.
+inline bool CacheReader::get_count(uint32_t &n, uint32_t min_item_size) {
+    return get(n) && n <= (uint32_t) (_end - _s) / min_item_size;
+}
+
+inline bool CacheReader::get64(unsigned long long &x) {
+    uint32_t lo, hi;
+    if (!get(lo) || !get(hi))
+        return false;
+    x = lo | ((unsigned long long) hi << 32);
+    return true;
+}
+
+#endif
@@ -254,6 +254,9 @@ void Clp_SetArguments(Clp_Parser *clp, int argc, const char * const *argv);
 /** @brief Set whether @a clp is searching for options. */
 int Clp_SetOptionProcessing(Clp_Parser *clp, int on);
 
+/** @brief Set whether @a clp expands <tt>@@FILE</tt> response files. */
+int Clp_SetResponseFiles(Clp_Parser *clp, int on);
+
 
 #define Clp_DisallowOptions     (1<<0)  /**< @brief Value type flag: value
                                              can't be an option string.
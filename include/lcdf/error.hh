@@ -2,6 +2,8 @@
 #ifndef LCDF_ERROR_HH
 #define LCDF_ERROR_HH
 #include <lcdf/string.hh>
+#include <lcdf/vector.hh>
+#include <lcdf/hashmap.hh>
 #ifndef __KERNEL__
 # include <stdio.h>
 #endif
@@ -623,7 +625,7 @@ class ErrorVeneer : public ErrorHandler { public:
     void *emit(const String &str, void *user_data, bool more);
     void account(int level);
 
-  private:
+  protected:
 
     ErrorHandler *_errh;
 
@@ -873,5 +875,75 @@ class BailErrorHandler : public ErrorVeneer { public:
 };
 #endif
 
+
+/** @class BufferedErrorHandler
+ * @brief A stackable ErrorHandler that queues messages.
+ *
+ * BufferedErrorHandler holds complete error messages, one record per
+ * message, and passes them to the base handler in order when flush() is
+ * called or the handler is destroyed.  A fatal message flushes the queue
+ * before it is passed on.  If aggregation is on, a message identical to an
+ * earlier queued message is not queued again; instead the earlier record's
+ * count goes up, and its first line is annotated with "{count:N}" when
+ * flushed. */
+class BufferedErrorHandler : public ErrorVeneer { public:
+
+    /** @brief Construct a BufferedErrorHandler.
+     * @param errh base ErrorHandler
+     * @param aggregate if true, fold duplicate messages together */
+    BufferedErrorHandler(ErrorHandler *errh, bool aggregate = false);
+    ~BufferedErrorHandler();
+
+    /** @brief Pass all queued messages to the base handler. */
+    void flush();
+
+    void *emit(const String &str, void *user_data, bool more);
+    void account(int level);
+
+  private:
+
+    struct Record {
+        String text;
+        int level;
+        int count;
+    };
+
+    Vector<Record> _records;
+    HashMap<String, int> _record_map;
+    String _pending;
+    bool _aggregate;
+
+};
+
+
+#ifndef __KERNEL__
+/** @class JsonErrorHandler
+ * @brief An ErrorHandler that prints messages as JSON lines.
+ *
+ * JsonErrorHandler writes each error message as a single JSON object on a
+ * line of its own, with "level", "landmark", and "message" members (plus
+ * "program" and "count" when known).  The whole line is written with one
+ * fwrite() call. */
+class JsonErrorHandler : public ErrorHandler { public:
+
+    /** @brief Construct a JsonErrorHandler.
+     * @param f file to print errors
+     * @param program program name reported in each record */
+    JsonErrorHandler(FILE *f, const String &program = String());
+
+    void *emit(const String &str, void *user_data, bool more);
+
+  private:
+
+    FILE *_f;
+    String _program;
+    String _message;
+    String _landmark;
+    int _level;
+    int _count;
+
+};
+#endif
+
 #undef ERRH_SENTINEL
 #endif
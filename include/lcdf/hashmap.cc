@@ -23,14 +23,14 @@
 
 template <class K, class V>
 HashMap<K, V>::HashMap()
-    : _capacity(0), _grow_limit(0), _n(0), _e(0), _default_value()
+    : _capacity(0), _grow_limit(0), _n(0), _e(0), _hc(0), _default_value()
 {
     increase(-1);
 }
 
 template <class K, class V>
 HashMap<K, V>::HashMap(const V &def)
-    : _capacity(0), _grow_limit(0), _n(0), _e(0), _default_value(def)
+    : _capacity(0), _grow_limit(0), _n(0), _e(0), _hc(0), _default_value(def)
 {
     increase(-1);
 }
@@ -39,10 +39,13 @@ HashMap<K, V>::HashMap(const V &def)
 template <class K, class V>
 HashMap<K, V>::HashMap(const HashMap<K, V> &m)
     : _capacity(m._capacity), _grow_limit(m._grow_limit), _n(m._n),
-      _e(new Pair[m._capacity]), _default_value(m._default_value)
+      _e(new Pair[m._capacity]), _hc(new hashcode_t[m._capacity]()),
+      _default_value(m._default_value)
 {
-    for (int i = 0; i < _capacity; i++)
+    for (int i = 0; i < _capacity; i++) {
 	_e[i] = m._e[i];
+	_hc[i] = m._hc[i];
+    }
 }
 
 
@@ -58,11 +61,16 @@ HashMap<K, V>::operator=(const HashMap<K, V> &o)
     _default_value = o._default_value;
 
     Pair *new_e = new Pair[_capacity];
-    for (int i = 0; i < _capacity; i++)
+    hashcode_t *new_hc = new hashcode_t[_capacity]();
+    for (int i = 0; i < _capacity; i++) {
 	new_e[i] = o._e[i];
+	new_hc[i] = o._hc[i];
+    }
 
     delete[] _e;
+    delete[] _hc;
     _e = new_e;
+    _hc = new_hc;
 
     return *this;
 }
@@ -79,23 +87,37 @@ HashMap<K, V>::increase(int min_size)
 	return;
 
     Pair *ne = new Pair[ncap];
-    if (!ne)			// out of memory
+    hashcode_t *nhc = new hashcode_t[ncap]();
+    if (!ne || !nhc) {		// out of memory
+	delete[] ne;
+	delete[] nhc;
 	return;
+    }
 
     Pair *oe = _e;
+    hashcode_t *ohc = _hc;
     int ocap = _capacity;
     _e = ne;
+    _hc = nhc;
     _capacity = ncap;
     _grow_limit = ((3 * _capacity) >> 2) - 1;
 
-    Pair *otrav = oe;
-    for (int i = 0; i < ocap; i++, otrav++)
-	if (otrav->key) {
-	    int j = bucket(otrav->key);
-	    _e[j] = *otrav;
+    // Rehash with the stored hashcodes, moving rather than copying pairs.
+    // Keys are distinct, so the first empty slot in the probe is the one.
+    for (int i = 0; i < ocap; i++)
+	if (oe[i].key) {
+	    hashcode_t hc = ohc[i];
+	    int j =   hc       & (_capacity - 1);
+	    int k = ((hc >> 6) & (_capacity - 1)) | 1;
+	    while (_e[j].key)
+		j = (j + k) & (_capacity - 1);
+	    _e[j].key = std::move(oe[i].key);
+	    _e[j].value = std::move(oe[i].value);
+	    _hc[j] = hc;
 	}
 
     delete[] oe;
+    delete[] ohc;
 }
 
 template <class K, class V>
@@ -111,10 +133,12 @@ bool
 HashMap<K, V>::insert(const K &key, const V &val)
 {
     check_capacity();
-    int i = bucket(key);
+    hashcode_t hc = hashcode(key);
+    int i = bucket(key, hc);
     bool is_new = !(bool)_e[i].key;
     _e[i].key = key;
     _e[i].value = val;
+    _hc[i] = hc;
     _n += is_new;
     return is_new;
 }
@@ -124,10 +148,12 @@ V &
 HashMap<K, V>::find_force(const K &key, const V &value)
 {
     check_capacity();
-    int i = bucket(key);
+    hashcode_t hc = hashcode(key);
+    int i = bucket(key, hc);
     if (!(bool)_e[i].key) {
 	_e[i].key = key;
 	_e[i].value = value;
+	_hc[i] = hc;
 	_n++;
     }
     return _e[i].value;
@@ -138,7 +164,9 @@ void
 HashMap<K, V>::clear()
 {
     delete[] _e;
+    delete[] _hc;
     _e = 0;
+    _hc = 0;
     _capacity = _grow_limit = _n = 0;
     increase(-1);
 }
@@ -151,16 +179,19 @@ HashMap<K, V>::swap(HashMap<K, V> &o)
     int grow_limit = _grow_limit;
     int n = _n;
     Pair *e = _e;
+    hashcode_t *hc = _hc;
     V default_value = _default_value;
     _capacity = o._capacity;
     _grow_limit = o._grow_limit;
     _n = o._n;
     _e = o._e;
+    _hc = o._hc;
     _default_value = o._default_value;
     o._capacity = capacity;
     o._grow_limit = grow_limit;
     o._n = n;
     o._e = e;
+    o._hc = hc;
     o._default_value = default_value;
 }
 
@@ -1,6 +1,7 @@
 #ifndef LCDF_HASHMAP_HH
 #define LCDF_HASHMAP_HH
 #include <assert.h>
+#include <utility>
 #include <lcdf/hashcode.hh>
 
 // K AND V REQUIREMENTS:
@@ -27,7 +28,7 @@ class HashMap { public:
     HashMap();
     explicit HashMap(const V &);
     HashMap(const HashMap<K, V> &);
-    ~HashMap()				{ delete[] _e; }
+    ~HashMap()				{ delete[] _e; delete[] _hc; }
 
     int size() const			{ return _n; }
     bool empty() const			{ return _n == 0; }
@@ -69,11 +70,13 @@ class HashMap { public:
     int _grow_limit;
     int _n;
     Pair *_e;
+    hashcode_t *_hc;		// hashcode of each occupied slot's key
     V _default_value;
 
     void increase(int);
     inline void check_capacity();
-    inline int bucket(const K &) const;
+    inline int bucket(const K &, hashcode_t) const;
+    inline int bucket(const K &key) const { return bucket(key, hashcode(key)); }
 
     friend class _HashMap_const_iterator<K, V>;
     friend class _HashMap_iterator<K, V>;
@@ -120,14 +123,14 @@ class _HashMap_iterator : public _HashMap_const_iterator<K, V> { public:
 
 template <class K, class V>
 inline int
-HashMap<K, V>::bucket(const K &key) const
+HashMap<K, V>::bucket(const K &key, hashcode_t hc) const
 {
     assert(key);
-    hashcode_t hc = hashcode(key);
     int i =   hc       & (_capacity - 1);
     int j = ((hc >> 6) & (_capacity - 1)) | 1;
 
-    while (_e[i].key && !(_e[i].key == key))
+    // compare stored hashcodes first; full key comparison only on a match
+    while (_e[i].key && !(_hc[i] == hc && _e[i].key == key))
 	i = (i + j) & (_capacity - 1);
 
     return i;
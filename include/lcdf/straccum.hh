@@ -109,6 +109,9 @@ class StringAccum { public:
     // word joining
     void append_break_lines(const String& text, int linelen, const String& leftmargin = String());
 
+    /** @brief Append @a str as a quoted, escaped JSON string. */
+    void append_json_string(const String& str);
+
     /** @brief Append result of snprintf() to this StringAccum.
      * @param n maximum number of characters to print
      * @param format format argument to snprintf()
@@ -143,6 +146,15 @@ class StringAccum { public:
 
     static const char* double_format;
 
+    /** @brief Format @a d into @a buf as snprintf("%.*g", @a precision, @a d).
+     * @param buf output buffer, at least @a n characters long
+     * @return number of characters written, not including the terminating
+     * null
+     *
+     * Integers and short binary fractions, such as 250 or 12.5, are
+     * formatted without calling snprintf. */
+    static int format_double(char* buf, int n, double d, int precision);
+
   private:
 
     enum {
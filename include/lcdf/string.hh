@@ -20,6 +20,14 @@ class String { public:
 	assign(x);
     }
 
+    /** @brief Construct a String by stealing the contents of @a x.
+     *
+     * @a x is left empty. */
+    inline String(String &&x) {
+	_r = x._r;
+	x.assign_memo(&null_data, 0, 0);
+    }
+
     /** @brief Construct a String containing the C string @a cstr.
      * @param cstr a null-terminated C string
      * @return A String containing the characters of @a cstr, up to but not
@@ -470,6 +478,16 @@ class String { public:
 	return *this;
     }
 
+    /** @brief Assign this string to @a x, leaving @a x empty. */
+    inline String &operator=(String &&x) {
+	if (&x != this) {
+	    deref();
+	    _r = x._r;
+	    x.assign_memo(&null_data, 0, 0);
+	}
+	return *this;
+    }
+
     /** @brief Assign this string to the C string @a cstr. */
     inline String &operator=(const char *cstr) {
 	assign(cstr, -1, true);
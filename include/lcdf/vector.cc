@@ -91,14 +91,17 @@ Vector<T>::insert(iterator it, const T &x)
 #ifdef VALGRIND_MAKE_MEM_UNDEFINED
     VALGRIND_MAKE_MEM_UNDEFINED(velt(_n), sizeof(T));
 #endif
-    for (iterator j = end(); j > it; ) {
-	--j;
-	new((void*) (j + 1)) T(*j);
-	j->~T();
+    if (trivial)
+	memmove((void*) (it + 1), (void*) it, (end() - it) * sizeof(T));
+    else
+	for (iterator j = end(); j > it; ) {
+	    --j;
+	    new((void*) (j + 1)) T(std::move(*j));
+	    j->~T();
 #ifdef VALGRIND_MAKE_MEM_UNDEFINED
-	VALGRIND_MAKE_MEM_UNDEFINED(j, sizeof(T));
+	    VALGRIND_MAKE_MEM_UNDEFINED(j, sizeof(T));
 #endif
-    }
+	}
     new((void*) it) T(x);
     _n++;
     return it;
@@ -110,13 +113,17 @@ Vector<T>::erase(iterator a, iterator b)
     if (b > a) {
 	assert(a >= begin() && b <= end());
 	iterator i = a, j = b;
-	for (; j < end(); i++, j++) {
-	    i->~T();
+	if (trivial) {
+	    memmove((void*) a, (void*) b, (end() - b) * sizeof(T));
+	    i += end() - b;
+	} else
+	    for (; j < end(); i++, j++) {
+		i->~T();
 #ifdef VALGRIND_MAKE_MEM_UNDEFINED
-	    VALGRIND_MAKE_MEM_UNDEFINED(i, sizeof(T));
+		VALGRIND_MAKE_MEM_UNDEFINED(i, sizeof(T));
 #endif
-	    new((void*) i) T(*j);
-	}
+		new((void*) i) T(std::move(*j));
+	    }
 	for (; i < end(); i++)
 	    i->~T();
 	_n -= b - a;
@@ -147,10 +154,14 @@ Vector<T>::reserve_and_push_back(size_type want, const T *push_x)
 	VALGRIND_MAKE_MEM_NOACCESS(new_l + _n, (want - _n) * sizeof(T));
 #endif
 
-	for (size_type i = 0; i < _n; i++) {
-	    new(velt(new_l, i)) T(_l[i]);
-	    _l[i].~T();
-	}
+	if (trivial) {
+	    if (_n)
+		memcpy((void*) new_l, (void*) _l, _n * sizeof(T));
+	} else
+	    for (size_type i = 0; i < _n; i++) {
+		new(velt(new_l, i)) T(std::move(_l[i]));
+		_l[i].~T();
+	    }
 	delete[] (unsigned char *)_l;
 
 	_l = new_l;
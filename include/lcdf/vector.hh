@@ -2,6 +2,9 @@
 #define LCDF_VECTOR_HH
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include <utility>
+#include <type_traits>
 #ifdef HAVE_NEW_HDR
 # include <new>
 #elif defined(HAVE_NEW_H)
@@ -38,9 +41,18 @@ class Vector { public:
     }
     // template <class In> ...
     Vector(const Vector<T> &x);
+    Vector(Vector<T> &&x)
+	: _l(x._l), _n(x._n), _capacity(x._capacity) {
+	x._l = 0;
+	x._n = x._capacity = 0;
+    }
     ~Vector();
 
     Vector<T>& operator=(const Vector<T>&);
+    Vector<T>& operator=(Vector<T> &&x) {
+	swap(x);
+	return *this;
+    }
     Vector<T>& assign(size_type n, const T& e = T());
     // template <class In> ...
 
@@ -77,6 +89,8 @@ class Vector { public:
 
     // modifiers
     inline void push_back(const T& x);
+    inline void push_back(T&& x);
+    template <class... Args> inline T& emplace_back(Args&&... args);
     inline void pop_back();
     inline void push_front(const T& x);
     inline void pop_front();
@@ -92,6 +106,10 @@ class Vector { public:
     size_type _n;
     size_type _capacity;
 
+    // Types that can be moved with memcpy/memmove, such as glyph IDs and
+    // small plain structs.
+    enum { trivial = std::is_trivially_copyable<T>::value };
+
     void *velt(size_type i) const		{ return (void *)&_l[i]; }
     static void *velt(T *l, size_type i)	{ return (void *)&l[i]; }
     bool reserve_and_push_back(size_type n, const T *x);
@@ -111,6 +129,41 @@ Vector<T>::push_back(const T& x)
 	reserve_and_push_back(RESERVE_GROW, &x);
 }
 
+template <class T> inline void
+Vector<T>::push_back(T&& x)
+{
+    if (_n < _capacity) {
+#ifdef VALGRIND_MAKE_MEM_UNDEFINED
+	VALGRIND_MAKE_MEM_UNDEFINED(velt(_n), sizeof(T));
+#endif
+	new(velt(_n)) T(std::move(x));
+	++_n;
+    } else if (&x >= begin() && &x < end()) {
+	T x_copy(std::move(x));
+	push_back(std::move(x_copy));
+    } else if (reserve_and_push_back(RESERVE_GROW, 0)) {
+	new(velt(_n)) T(std::move(x));
+	++_n;
+    }
+}
+
+template <class T> template <class... Args> inline T&
+Vector<T>::emplace_back(Args&&... args)
+{
+    if (_n == _capacity) {
+	// construct first: an argument might refer into this vector
+	T x(std::forward<Args>(args)...);
+	push_back(std::move(x));
+    } else {
+#ifdef VALGRIND_MAKE_MEM_UNDEFINED
+	VALGRIND_MAKE_MEM_UNDEFINED(velt(_n), sizeof(T));
+#endif
+	new(velt(_n)) T(std::forward<Args>(args)...);
+	++_n;
+    }
+    return _l[_n - 1];
+}
+
 template <class T> inline void
 Vector<T>::pop_back()
 {
@@ -165,9 +218,18 @@ class Vector<void*> { public:
 	resize(n, e);
     }
     Vector(const Vector<void*> &);
+    Vector(Vector<void*> &&x)
+	: _l(x._l), _n(x._n), _capacity(x._capacity) {
+	x._l = 0;
+	x._n = x._capacity = 0;
+    }
     ~Vector();
 
     Vector<void*> &operator=(const Vector<void*> &);
+    Vector<void*> &operator=(Vector<void*> &&x) {
+	swap(x);
+	return *this;
+    }
     Vector<void*> &assign(size_type n, void* x = 0);
 
     // iterators
@@ -197,6 +259,7 @@ class Vector<void*> { public:
 
     // modifiers
     inline void push_back(void* x);
+    void*& emplace_back(void* x)	{ push_back(x); return back(); }
     inline void pop_back();
     inline void push_front(void* x);
     inline void pop_front();
@@ -275,10 +338,13 @@ class Vector<T*>: private Vector<void*> {
     explicit Vector()			: Base() { }
     explicit Vector(size_type n, T* x)	: Base(n, (void *)x) { }
     Vector(const Vector<T*>& x)		: Base(x) { }
+    Vector(Vector<T*>&& x)		: Base(std::move(x)) { }
     ~Vector()				{ }
 
     Vector<T*>& operator=(const Vector<T*>& x)
 		{ Base::operator=(x); return *this; }
+    Vector<T*>& operator=(Vector<T*>&& x)
+		{ Base::operator=(std::move(x)); return *this; }
     Vector<T*>& assign(size_type n, T* x = 0)
 		{ Base::assign(n, (void*)x); return *this; }
 
@@ -309,6 +375,7 @@ class Vector<T*>: private Vector<void*> {
 
     // modifiers
     void push_back(T* x)	{ Base::push_back((void*)x); }
+    T*& emplace_back(T* x)	{ Base::push_back((void*)x); return back(); }
     void pop_back()		{ Base::pop_back(); }
     void push_front(T* x)	{ Base::push_front((void*)x); }
     void pop_front()		{ Base::pop_front(); }
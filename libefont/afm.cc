@@ -335,8 +335,9 @@ AfmReader::read_char_metric_data() const
 
     AfmParser &l = _l;
 
-    l.is("C %d ; WX %g ; N %/s ; B %g %g %g %g ;",
-         &c, &wx, &n, &bllx, &blly, &burx, &bury);
+    if (!l.is_char_metric(c, wx, n, bllx, blly, burx, bury))
+        l.is("C %d ; WX %g ; N %/s ; B %g %g %g %g ;",
+             &c, &wx, &n, &bllx, &blly, &burx, &bury);
 
     while (l.left()) {
 
@@ -476,7 +477,7 @@ AfmReader::read_char_metrics() const
 void
 AfmReader::read_kerns() const
 {
-    double kx;
+    double kx, ky;
     PermString left, right;
     GlyphIndex leftgi, rightgi;
 
@@ -502,14 +503,16 @@ AfmReader::read_kerns() const
             goto invalid;
 
           case 'K':
-            if (l.isall("KPX %/s %/s %g", &left, &right, &kx)) {
+            if (l.isall_kern_pair("KPX", left, right, kx)
+                || l.isall("KPX %/s %/s %g", &left, &right, &kx)) {
                 goto validkern;
             }
             if (l.isall("KP %/s %/s %g %g", &left, &right, &kx, (double *)0)) {
                 y_width_warning();
                 goto validkern;
             }
-            if (l.isall("KPY %/s %/s %g", &left, &right, (double *)0)) {
+            if (l.isall_kern_pair("KPY", left, right, ky)
+                || l.isall("KPY %/s %/s %g", &left, &right, (double *)0)) {
                 y_width_warning();
                 break;
             }
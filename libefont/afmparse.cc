@@ -342,6 +342,171 @@ AfmParser::is(const char *format, ...)
 }
 
 
+// Branch-light scanners for the fast paths. They accept a subset of what
+// vis() accepts and return false on anything else, so results are
+// identical to the format matcher's.
+
+static const double fast_powers_of_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15
+};
+
+static inline bool
+fast_space(unsigned char *&s)
+{
+    if (!isspace(*s))
+        return false;
+    do {
+        s++;
+    } while (isspace(*s));
+    return true;
+}
+
+static inline bool
+fast_char(unsigned char *&s, unsigned char c)
+{
+    return *s == c ? (s++, true) : false;
+}
+
+static inline bool
+fast_keyword(unsigned char *&s, const char *keyword)
+{
+    unsigned char *x = s;
+    while (*keyword)
+        if (*x++ != (unsigned char) *keyword++)
+            return false;
+    if (isalnum(*x))
+        return false;
+    s = x;
+    return true;
+}
+
+static inline bool
+fast_name(unsigned char *&s, PermString &n)
+{
+    unsigned char *x = s;
+    while (!name_enders[*x])
+        x++;
+    if (x == s)
+        return false;
+    n = PermString((char *) s, x - s);
+    s = x;
+    return true;
+}
+
+static inline bool
+fast_integer(unsigned char *&s, int &v)
+{
+    unsigned char *x = s;
+    bool neg = (*x == '-');
+    x += neg;
+    unsigned char *digits = x;
+    int i = 0;
+    for (unsigned d; (d = *x - '0') < 10; x++)
+        i = i * 10 + d;
+    // defer to strtol for overflow and odd syntax
+    if (x == digits || x - digits > 9)
+        return false;
+    v = neg ? -i : i;
+    s = x;
+    return true;
+}
+
+static inline bool
+fast_number(unsigned char *&s, double &v)
+{
+    unsigned char *x = s;
+    bool neg = (*x == '-');
+    x += neg;
+    unsigned char *digits = x;
+    int64_t m = 0;
+    for (unsigned d; (d = *x - '0') < 10; x++)
+        m = m * 10 + d;
+    int ndigits = x - digits;
+    if (ndigits == 0 || ndigits > 15)
+        return false;
+    if (*x == '.') {
+        unsigned char *frac = ++x;
+        for (unsigned d; (d = *x - '0') < 10; x++)
+            m = m * 10 + d;
+        ndigits += x - frac;
+        if (ndigits > 15)
+            return false;
+        // both operands are exact, so the quotient is correctly rounded,
+        // just like strtod's result
+        v = m / fast_powers_of_10[x - frac];
+        if (neg)
+            v = -v;
+    } else
+        v = (double) (neg ? -m : m);
+    if (*x == 'e' || *x == 'E')
+        return false;
+    s = x;
+    return true;
+}
+
+bool
+AfmParser::is_char_metric(int &c, double &wx, PermString &n, double &llx,
+                          double &lly, double &urx, double &ury)
+{
+    // is("C %d ; WX %g ; N %/s ; B %g %g %g %g ;", ...)
+    unsigned char *s = _pos;
+    int cx;
+    double wxx, b[4];
+    PermString nx;
+    if (!(fast_keyword(s, "C") && fast_space(s) && fast_integer(s, cx)
+          && fast_space(s) && fast_char(s, ';') && fast_space(s)
+          && fast_keyword(s, "WX") && fast_space(s) && fast_number(s, wxx)
+          && fast_space(s) && fast_char(s, ';') && fast_space(s)
+          && fast_keyword(s, "N") && fast_space(s) && fast_name(s, nx)
+          && fast_space(s) && fast_char(s, ';') && fast_space(s)
+          && fast_keyword(s, "B") && fast_space(s) && fast_number(s, b[0])
+          && fast_space(s) && fast_number(s, b[1])
+          && fast_space(s) && fast_number(s, b[2])
+          && fast_space(s) && fast_number(s, b[3])
+          && fast_space(s) && fast_char(s, ';')))
+        return false;
+    while (isspace(*s))
+        s++;
+    c = cx;
+    wx = wxx;
+    n = nx;
+    llx = b[0];
+    lly = b[1];
+    urx = b[2];
+    ury = b[3];
+    _pos = s;
+    _fail_field = 7;
+    _message = PermString();
+    return true;
+}
+
+bool
+AfmParser::isall_kern_pair(const char *keyword, PermString &left,
+                           PermString &right, double &amount)
+{
+    // isall("<keyword> %/s %/s %g", ...)
+    unsigned char *s = _pos;
+    PermString l, r;
+    double a;
+    if (!(fast_keyword(s, keyword) && fast_space(s) && fast_name(s, l)
+          && fast_space(s) && fast_name(s, r)
+          && fast_space(s) && fast_number(s, a)))
+        return false;
+    while (isspace(*s))
+        s++;
+    if (*s)
+        return false;
+    left = l;
+    right = r;
+    amount = a;
+    _pos = s;
+    _fail_field = 3;
+    _message = PermString();
+    return true;
+}
+
+
 PermString
 AfmParser::keyword() const
 {
@@ -123,6 +123,7 @@ AmfmMetrics::master(int m, ErrorHandler *errh)
             master.afm = afm;
             _sanity_afm = afm;
             afm->use();
+            afm->pair_program()->freeze();
 
         } else {
             PairProgram *sanity_pairp = _sanity_afm->pair_program();
@@ -142,6 +143,7 @@ AmfmMetrics::master(int m, ErrorHandler *errh)
             if (!buf[0]) {
                 master.afm = afm;
                 afm->use();
+                pairp->freeze();
             } else if (errh)
                 errh->error("%s: AFM for master %<%s%> failed sanity checks (%s)", _font_name.c_str(), master.font_name.c_str(), buf);
         }
@@ -169,25 +171,9 @@ AmfmMetrics::find_primary_font(const Vector<double> &design_vector) const
 
 
 Metrics *
-AmfmMetrics::interpolate(const Vector<double> &design_vector,
-                         const Vector<double> &weight_vector,
-                         ErrorHandler *errh)
+AmfmMetrics::new_instance(const Vector<double> &design_vector, int m) const
 {
-    assert(design_vector.size() == _naxes);
-    assert(weight_vector.size() == _nmasters);
-
-    // FIXME: check masters for correspondence.
-
-    /* 0.
-     * Make sure all necessary AFMs have been loaded. */
-    int m;
-    for (m = 0; m < _nmasters; m++)
-        if (weight_vector[m])
-            if (!master(m, errh))
-                return 0;
-
-    /* 1.
-     * Use the design vector to generate new FontName and FullName. */
+    /* Use the design vector to generate new FontName and FullName. */
 
     AmfmPrimaryFont *pf = find_primary_font(design_vector);
     // The primary font is useless to us if it doesn't have axis labels.
@@ -213,28 +199,92 @@ AmfmMetrics::interpolate(const Vector<double> &design_vector,
     // Multiple master fonts require an underscore AFTER the font name too
     font_name_sa << '_';
 
-    /* 2.
-     * Set up the new AFM with the special constructor. */
+    /* Set up the new AFM with the special constructor, based on master
+       'm'. */
 
-    // Find the first master with a non-zero component.
-    for (m = 0; m < _nmasters && weight_vector[m] == 0; m++)
-        ;
     Metrics *afm = new Metrics(font_name_sa.c_str(), full_name_sa.c_str(), *_masters[m].afm);
     if (MetricsXt *xt = _masters[m].afm->find_xt("AFM")) {
         AfmMetricsXt *new_xt = new AfmMetricsXt((AfmMetricsXt &)*xt);
         afm->add_xt(new_xt);
     }
+    return afm;
+}
 
-    /* 2.
-     * Interpolate the old AFM data into the new. */
+Metrics *
+AmfmMetrics::interpolate(const Vector<double> &design_vector,
+                         const Vector<double> &weight_vector,
+                         ErrorHandler *errh)
+{
+    Vector<Vector<double> > designs(1, design_vector);
+    Vector<Vector<double> > weights(1, weight_vector);
+    Vector<Metrics *> results;
+    if (interpolate(designs, weights, results, errh))
+        return results[0];
+    else
+        return 0;
+}
 
-    afm->interpolate_dimens(*_masters[m].afm, weight_vector[m], false);
+bool
+AmfmMetrics::interpolate(const Vector<Vector<double> > &design_vectors,
+                         const Vector<Vector<double> > &weight_vectors,
+                         Vector<Metrics *> &results,
+                         ErrorHandler *errh)
+{
+    assert(design_vectors.size() == weight_vectors.size());
+    int ninstances = design_vectors.size();
+    results.clear();
 
-    for (m++; m < _nmasters; m++)
-        if (weight_vector[m])
-            afm->interpolate_dimens(*_masters[m].afm, weight_vector[m], true);
+    // FIXME: check masters for correspondence.
 
-    return afm;
+    /* 0.
+     * Make sure all necessary AFMs have been loaded. Find each instance's
+     * first master with a non-zero component; the instance's glyphs, kern
+     * pairs, and so forth come from that master. */
+    Vector<const Metrics *> masters(_nmasters, (const Metrics *) 0);
+    Vector<int> first_master(ninstances, -1);
+    for (int i = 0; i < ninstances; i++) {
+        assert(design_vectors[i].size() == _naxes);
+        assert(weight_vectors[i].size() == _nmasters);
+        for (int m = 0; m < _nmasters; m++)
+            if (weight_vectors[i][m]) {
+                if (!masters[m] && !(masters[m] = master(m, errh)))
+                    return false;
+                if (first_master[i] < 0)
+                    first_master[i] = m;
+            }
+        if (first_master[i] < 0) {
+            if (errh)
+                errh->error("%s: weight vector is all zeros", _font_name.c_str());
+            return false;
+        }
+    }
+
+    /* 1.
+     * Create the instances. */
+    for (int i = 0; i < ninstances; i++)
+        results.push_back(new_instance(design_vectors[i], first_master[i]));
+
+    /* 2.
+     * Interpolate the old AFM data into the new, all instances with the
+     * same first master at once. */
+    Vector<int> done(ninstances, 0);
+    Vector<Metrics *> group;
+    Vector<double> weights;
+    for (int i = 0; i < ninstances; i++)
+        if (!done[i]) {
+            group.clear();
+            weights.clear();
+            for (int j = i; j < ninstances; j++)
+                if (first_master[j] == first_master[i]) {
+                    group.push_back(results[j]);
+                    for (int m = 0; m < _nmasters; m++)
+                        weights.push_back(weight_vectors[j][m]);
+                    done[j] = 1;
+                }
+            Metrics::interpolate_dimens(masters, weights, group);
+        }
+
+    return true;
 }
 
 
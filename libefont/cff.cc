@@ -428,7 +428,7 @@ Cff::sid(PermString s)
         return -1;
 
     // check standard strings
-    if (standard_permstrings_map["a"] < 0)
+    if (standard_permstrings_map.empty())
         for (int i = 0; i < NSTANDARD_STRINGS; i++) {
             if (!standard_permstrings[i])
                 standard_permstrings[i] = PermString(standard_strings[i]);
@@ -443,15 +443,23 @@ Cff::sid(PermString s)
     if (sid >= -1)
         return sid;
 
+    // On the first miss, enter every remaining string into the map, so
+    // later lookups are hash probes rather than scans of the Strings INDEX.
+    // The first of any duplicate strings wins.
     for (int i = 0; i < _strings.size(); i++)
-        if (!_strings[i] && s.length() == _strings_index[i+1] - _strings_index[i] && memcmp(s.c_str(), _strings_index[i], s.length()) == 0) {
-            _strings[i] = s;
-            _strings_map.insert(s, i + NSTANDARD_STRINGS);
-            return i + NSTANDARD_STRINGS;
+        if (!_strings[i]) {
+            PermString x(reinterpret_cast<const char *>(_strings_index[i]), _strings_index[i+1] - _strings_index[i]);
+            _strings[i] = x;
+            if (_strings_map[x] < -1)
+                _strings_map.insert(x, i + NSTANDARD_STRINGS);
         }
 
-    _strings_map.insert(s, -1);
-    return -1;
+    sid = _strings_map[s];
+    if (sid < -1) {
+        _strings_map.insert(s, -1);
+        sid = -1;
+    }
+    return sid;
 }
 
 String
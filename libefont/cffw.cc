@@ -0,0 +1,1025 @@
+// -*- related-file-name: "../include/efont/cffw.hh" -*-
+
+/* cffw.{cc,hh} -- Compact Font Format writing
+ *
+ * Copyright (c) 2026 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <efont/cffw.hh>
+#include <efont/t1subrize.hh>
+#include <efont/t1interp.hh>
+#include <efont/otfcmap.hh>
+#include <efont/otfdata.hh>
+#include <lcdf/straccum.hh>
+#include <lcdf/error.hh>
+#include <algorithm>
+#include <utility>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+namespace Efont {
+
+static inline void
+append_u16(StringAccum &sa, unsigned x)
+{
+    sa.append((char) (x >> 8));
+    sa.append((char) x);
+}
+
+static inline void
+append_u32(StringAccum &sa, uint32_t x)
+{
+    append_u16(sa, x >> 16);
+    append_u16(sa, x);
+}
+
+static void
+append_offset(StringAccum &sa, uint32_t x, int offsize)
+{
+    for (int shift = (offsize - 1) * 8; shift >= 0; shift -= 8)
+        sa.append((char) (x >> shift));
+}
+
+static void
+write_index(StringAccum &sa, const Vector<String> &items)
+{
+    append_u16(sa, items.size());
+    if (!items.size())
+        return;
+    uint32_t total = 1;
+    for (const String *s = items.begin(); s != items.end(); ++s)
+        total += s->length();
+    int offsize = (total < 0x100 ? 1 : (total < 0x10000 ? 2 : (total < 0x1000000 ? 3 : 4)));
+    sa.append((char) offsize);
+    uint32_t offset = 1;
+    append_offset(sa, offset, offsize);
+    for (const String *s = items.begin(); s != items.end(); ++s) {
+        offset += s->length();
+        append_offset(sa, offset, offsize);
+    }
+    for (const String *s = items.begin(); s != items.end(); ++s)
+        sa << *s;
+}
+
+static void
+append_t2_number(StringAccum &sa, int x)
+{
+    if (x >= -107 && x <= 107)
+        sa.append((char) (x + 139));
+    else if (x >= 108 && x <= 1131) {
+        x -= 108;
+        sa.append((char) ((x >> 8) + 247));
+        sa.append((char) x);
+    } else if (x >= -1131 && x <= -108) {
+        x = -x - 108;
+        sa.append((char) ((x >> 8) + 251));
+        sa.append((char) x);
+    } else {
+        sa.append((char) Charstring::cShortint);
+        append_u16(sa, x);
+    }
+}
+
+static void
+append_dict_operator(StringAccum &sa, int op)
+{
+    if (op >= 32)
+        sa.append((char) 12);
+    sa.append((char) (op & 31));
+}
+
+// offsets are always written in the five-byte form, so a DICT's size
+// doesn't depend on where things end up
+static void
+append_dict_offset(StringAccum &sa, uint32_t x)
+{
+    sa.append((char) 29);
+    append_u32(sa, x);
+}
+
+static void
+append_dict_number(StringAccum &sa, double x)
+{
+    if (x == floor(x) && x >= -2147483647.0 && x <= 2147483647.0) {
+        int i = (int) x;
+        if (i >= -107 && i <= 107)
+            sa.append((char) (i + 139));
+        else if (i >= 108 && i <= 1131) {
+            i -= 108;
+            sa.append((char) ((i >> 8) + 247));
+            sa.append((char) i);
+        } else if (i >= -1131 && i <= -108) {
+            i = -i - 108;
+            sa.append((char) ((i >> 8) + 251));
+            sa.append((char) i);
+        } else if (i >= -32768 && i <= 32767) {
+            sa.append((char) 28);
+            append_u16(sa, i);
+        } else
+            append_dict_offset(sa, i);
+        return;
+    }
+
+    // shortest decimal representation that reads back the same
+    char buf[64];
+    for (int prec = 6; prec <= 17; ++prec) {
+        snprintf(buf, sizeof(buf), "%.*g", prec, x);
+        if (strtod(buf, 0) == x)
+            break;
+    }
+
+    int nibbles[128], n = 0;
+    for (const char *s = buf; *s && n < 124; ++s)
+        if (*s >= '0' && *s <= '9')
+            nibbles[n++] = *s - '0';
+        else if (*s == '.')
+            nibbles[n++] = 10;
+        else if (*s == 'e' || *s == 'E') {
+            if (s[1] == '-') {
+                nibbles[n++] = 12;
+                ++s;
+            } else {
+                nibbles[n++] = 11;
+                if (s[1] == '+')
+                    ++s;
+            }
+        } else if (*s == '-')
+            nibbles[n++] = 14;
+    nibbles[n++] = 15;
+    if (n & 1)
+        nibbles[n++] = 15;
+
+    sa.append((char) 30);
+    for (int i = 0; i < n; i += 2)
+        sa.append((char) ((nibbles[i] << 4) | nibbles[i + 1]));
+}
+
+static inline int
+subr_bias(int nsubrs)
+{
+    if (nsubrs < 1240)
+        return 107;
+    else if (nsubrs < 33900)
+        return 1131;
+    else
+        return 32768;
+}
+
+
+/*****
+ * flattening
+ **/
+
+namespace {
+struct FlattenState {
+    int nstems;
+    int nargs;
+    int last_arg_pos;
+    int last_arg;
+    bool done;
+    FlattenState()
+        : nstems(0), nargs(0), last_arg_pos(-1), last_arg(0), done(false) {
+    }
+};
+}
+
+static bool
+flatten_charstring(const CharstringProgram *program, const Charstring *cs,
+                   StringAccum &sa, FlattenState &st, int depth)
+{
+    const Type2Charstring *t2cs = dynamic_cast<const Type2Charstring *>(cs);
+    if (!t2cs || depth > CharstringInterp::MAX_SUBR_DEPTH)
+        return false;
+    const uint8_t *data = t2cs->data();
+    const uint8_t *end = data + t2cs->length();
+
+    while (data < end) {
+        int c = *data;
+
+        if (c >= 32 || c == Charstring::cShortint) {
+            int n = (c == Charstring::cShortint ? 3 : (c <= 246 ? 1 : (c <= 254 ? 2 : 5)));
+            if (data + n > end)
+                return false;
+            st.last_arg_pos = sa.length();
+            if (c == Charstring::cShortint)
+                st.last_arg = (int16_t) ((data[1] << 8) | data[2]);
+            else if (c <= 246)
+                st.last_arg = c - 139;
+            else if (c <= 250)
+                st.last_arg = ((c - 247) << 8) + data[1] + 108;
+            else if (c <= 254)
+                st.last_arg = -((c - 251) << 8) - data[1] - 108;
+            else            // 16.16 fixed: can't be a subroutine number
+                st.last_arg_pos = -1;
+            sa.append(data, n);
+            data += n;
+            st.nargs++;
+            continue;
+        }
+
+        switch (c) {
+
+          case Charstring::cCallsubr:
+          case Charstring::cCallgsubr: {
+              if (st.last_arg_pos < 0)
+                  return false;
+              sa.set_length(st.last_arg_pos);
+              st.nargs--;
+              st.last_arg_pos = -1;
+              bool g = (c == Charstring::cCallgsubr);
+              const Charstring *subr = program->xsubr(g, st.last_arg);
+              if (!subr || !flatten_charstring(program, subr, sa, st, depth + 1))
+                  return false;
+              if (st.done)
+                  return true;
+              data++;
+              continue;
+          }
+
+          case Charstring::cReturn:
+            return true;
+
+          case Charstring::cEndchar:
+            sa.append((char) c);
+            st.done = true;
+            return true;
+
+          case Charstring::cHstem:
+          case Charstring::cVstem:
+          case Charstring::cHstemhm:
+          case Charstring::cVstemhm:
+            st.nstems += st.nargs / 2;
+            sa.append((char) c);
+            data++;
+            break;
+
+          case Charstring::cHintmask:
+          case Charstring::cCntrmask: {
+              st.nstems += st.nargs / 2;
+              int n = 1 + ((st.nstems + 7) >> 3);
+              if (data + n > end)
+                  return false;
+              sa.append(data, n);
+              data += n;
+              break;
+          }
+
+          case Charstring::cEscape:
+            if (data + 2 > end)
+                return false;
+            sa.append(data, 2);
+            data += 2;
+            break;
+
+          default:
+            sa.append((char) c);
+            data++;
+            break;
+
+        }
+
+        st.nargs = 0;
+        st.last_arg_pos = -1;
+    }
+
+    return true;
+}
+
+bool
+CffWriter::flatten(int gid, String &out)
+{
+    CharstringContext ctx = _font->glyph_context(gid);
+    if (!ctx.program)
+        return false;
+    StringAccum sa;
+    FlattenState st;
+    if (ctx.cs && !flatten_charstring(ctx.program, ctx.cs, sa, st, 0))
+        return false;
+    if (!st.done)
+        sa.append((char) Charstring::cEndchar);
+    out = sa.take_string();
+    return true;
+}
+
+
+/*****
+ * subroutinization
+ **/
+
+class CffWriter::Subroutinizer : public CharstringSubroutinizer { public:
+
+    Subroutinizer(int nglyphs)
+        : CharstringSubroutinizer(nglyphs) {
+    }
+
+    void tokenize(int first_glyph, int last_glyph);
+
+  private:
+
+    int call_bytes(int i) const;
+    int subr_overhead() const                   { return 3; }
+
+};
+
+int
+CffWriter::Subroutinizer::call_bytes(int i) const
+{
+    if (i < 215)
+        return 2;
+    else if (i < 2263)
+        return 3;
+    else
+        return 4;
+}
+
+void
+CffWriter::Subroutinizer::tokenize(int first_glyph, int last_glyph)
+{
+    // Path commands move. So does a moveto, except when it is the glyph's
+    // first stack-clearing operator and might carry the advance width.
+    // Hints stay where they are, so hintmask lengths never change.
+    for (int g = first_glyph; g < last_glyph; ++g) {
+        Vector<int> &offsets = _glyph_offsets[g];
+        offsets.clear();
+        const uint8_t *data = charstring(g).udata();
+        int len = charstring(g).length();
+
+        int pos = 0, start = 0, nargs = 0, nstems = 0;
+        bool seen_clear = false;
+        while (pos < len) {
+            int c = data[pos];
+            if (c >= 32 || c == Charstring::cShortint) {
+                pos += (c == Charstring::cShortint ? 3 : (c <= 246 ? 1 : (c <= 254 ? 2 : 5)));
+                nargs++;
+                continue;
+            }
+
+            int cmd = c;
+            if (c == Charstring::cEscape) {
+                cmd = Charstring::cEscapeDelta + (pos + 1 < len ? data[pos + 1] : 0);
+                pos += 2;
+            } else
+                pos++;
+
+            bool movable = false;
+            switch (cmd) {
+              case Charstring::cHstem:
+              case Charstring::cVstem:
+              case Charstring::cHstemhm:
+              case Charstring::cVstemhm:
+                nstems += nargs / 2;
+                seen_clear = true;
+                break;
+              case Charstring::cHintmask:
+              case Charstring::cCntrmask:
+                nstems += nargs / 2;
+                pos += (nstems + 7) >> 3;
+                seen_clear = true;
+                break;
+              case Charstring::cRmoveto:
+              case Charstring::cHmoveto:
+              case Charstring::cVmoveto:
+                movable = seen_clear;
+                seen_clear = true;
+                break;
+              case Charstring::cRlineto:
+              case Charstring::cHlineto:
+              case Charstring::cVlineto:
+              case Charstring::cRrcurveto:
+              case Charstring::cRcurveline:
+              case Charstring::cRlinecurve:
+              case Charstring::cVvcurveto:
+              case Charstring::cHhcurveto:
+              case Charstring::cVhcurveto:
+              case Charstring::cHvcurveto:
+              case Charstring::cHflex:
+              case Charstring::cFlex:
+              case Charstring::cHflex1:
+              case Charstring::cFlex1:
+                movable = true;
+                break;
+              default:
+                break;
+            }
+
+            if (pos > len)
+                pos = len;
+            nargs = 0;
+            offsets.push_back((start << 1) | movable);
+            start = pos;
+        }
+        if (start < len)
+            offsets.push_back(start << 1);
+        offsets.push_back(len << 1);
+    }
+}
+
+namespace {
+struct SubrOrderCmp {
+    const CharstringSubroutinizer &subrizer;
+    SubrOrderCmp(const CharstringSubroutinizer &subrizer_)
+        : subrizer(subrizer_) {
+    }
+    bool operator()(const std::pair<int, int> &a, const std::pair<int, int> &b) const {
+        // by INDEX, then most-called first
+        if (a.first != b.first)
+            return a.first < b.first;
+        int ca = subrizer.subr_ncalls(a.second), cb = subrizer.subr_ncalls(b.second);
+        return ca > cb || (ca == cb && a.second < b.second);
+    }
+};
+}
+
+void
+CffWriter::subroutinize_charstrings()
+{
+    int nglyphs = _charstrings.size();
+    Subroutinizer subrizer(nglyphs);
+    for (int g = 0; g < nglyphs; ++g)
+        subrizer.set_charstring(g, _charstrings[g]);
+    subrizer.tokenize(0, nglyphs);
+    if (!subrizer.choose_subrs())
+        return;
+
+    // A subroutine called only from one Font DICT's glyphs goes in that
+    // Font DICT's local Subrs; -1 means the global Subrs.
+    Vector<Vector<int> > callers;
+    subrizer.subr_callers(callers);
+    Vector<std::pair<int, int> > order;
+    for (int i = 0; i < callers.size(); ++i) {
+        int fd = _fds[callers[i][0]];
+        for (int *g = callers[i].begin(); g != callers[i].end(); ++g)
+            if (_fds[*g] != fd) {
+                fd = -1;
+                break;
+            }
+        order.push_back(std::make_pair(fd, i));
+    }
+    std::sort(order.begin(), order.end(), SubrOrderCmp(subrizer));
+
+    for (int i = 0; i < order.size(); ) {
+        int fd = order[i].first, j = i;
+        while (j < order.size() && order[j].first == fd)
+            ++j;
+        Vector<String> &subrs = (fd < 0 ? _global_subrs : _local_subrs[fd]);
+        int bias = subr_bias(j - i);
+        for (; i < j; ++i) {
+            int subrno = subrs.size();
+            subrs.push_back(subrizer.subr_body(order[i].second) + "\013");
+            StringAccum call;
+            append_t2_number(call, subrno - bias);
+            call.append((char) (fd < 0 ? Charstring::cCallgsubr : Charstring::cCallsubr));
+            subrizer.set_subr_call(order[i].second, call.take_string());
+        }
+    }
+
+    subrizer.rewrite(0, nglyphs);
+    for (int g = 0; g < nglyphs; ++g)
+        _charstrings[g] = subrizer.charstring(g);
+}
+
+
+/*****
+ * CffWriter
+ **/
+
+CffWriter::CffWriter(Cff::FontParent *font, ErrorHandler *errh)
+    : _font(font), _t1font(dynamic_cast<Cff::Font *>(font)),
+      _cidfont(dynamic_cast<Cff::CIDFont *>(font)), _cff(font->_cff),
+      _errh(errh ? errh : ErrorHandler::silent_handler()),
+      _subroutinize(true), _gid_map(font->nglyphs(), -1), _string_map(-1)
+{
+    if (font->nglyphs() > 0) {
+        _gids.push_back(0);
+        _gid_map[0] = 0;
+    }
+}
+
+bool
+CffWriter::add_glyph(int gid)
+{
+    if (gid < 0 || gid >= _gid_map.size())
+        return false;
+    if (_gid_map[gid] < 0) {
+        _gid_map[gid] = _gids.size();
+        _gids.push_back(gid);
+    }
+    return true;
+}
+
+bool
+CffWriter::add_glyph(PermString name)
+{
+    if (_t1font)
+        return add_glyph(_t1font->glyphid(name));
+    else if (_cidfont)
+        return add_glyph(_cidfont->glyphid(name));
+    else
+        return false;
+}
+
+int
+CffWriter::sid(PermString s)
+{
+    int x = _cff->sid(s);
+    if (x >= 0 && x < Cff::NSTANDARD_STRINGS)
+        return x;
+    int &sidp = _string_map.find_force(s);
+    if (sidp < 0) {
+        sidp = Cff::NSTANDARD_STRINGS + _strings.size();
+        _strings.push_back(String(s));
+    }
+    return sidp;
+}
+
+int
+CffWriter::copy_sid(int old_sid)
+{
+    if (old_sid < Cff::NSTANDARD_STRINGS)
+        return old_sid;
+    return sid(_cff->sid_permstring(old_sid));
+}
+
+void
+CffWriter::write_dict(StringAccum &sa, const Cff::Dict &dict, bool is_top)
+{
+    bool subset = (_gids.size() < _gid_map.size());
+    for (int i = 0; i < dict._operators.size(); ++i) {
+        int op = dict._operators[i];
+        int type = (op <= Cff::oLastOperator ? Cff::operator_types[op] & Cff::tTypeMask : Cff::tNone);
+        if (type == Cff::tOffset || type == Cff::tLocalOffset
+            || type == Cff::tPrivateType
+            || (subset && (op == Cff::oUniqueID || op == Cff::oXUID))
+            || (is_top && op == Cff::oCharstringType))
+            continue;
+        for (int j = dict._pointers[i]; j < dict._pointers[i + 1]; ++j) {
+            double v = dict._operands[j];
+            if (type == Cff::tSID
+                || (op == Cff::oROS && j < dict._pointers[i] + 2))
+                v = copy_sid((int) v);
+            append_dict_number(sa, v);
+        }
+        append_dict_operator(sa, op);
+    }
+}
+
+void
+CffWriter::write_charset(StringAccum &sa)
+{
+    Vector<int> sids;
+    for (int i = 1; i < _gids.size(); ++i)
+        if (_cidfont)
+            sids.push_back(_cidfont->_charset.gid_to_sid(_gids[i]));
+        else
+            sids.push_back(sid(_t1font->glyph_name(_gids[i])));
+
+    // format 2 (ranges) if smaller than format 0
+    int nranges = 0;
+    for (int i = 0; i < sids.size(); ++i)
+        if (i == 0 || sids[i] != sids[i - 1] + 1 || sids[i] - sids[i - nranges] > 65535)
+            ++nranges;
+    if (4 * nranges < 2 * sids.size()) {
+        sa.append((char) 2);
+        for (int i = 0; i < sids.size(); ) {
+            int j = i + 1;
+            while (j < sids.size() && sids[j] == sids[j - 1] + 1 && j - i <= 65535)
+                ++j;
+            append_u16(sa, sids[i]);
+            append_u16(sa, j - i - 1);
+            i = j;
+        }
+    } else {
+        sa.append((char) 0);
+        for (int i = 0; i < sids.size(); ++i)
+            append_u16(sa, sids[i]);
+    }
+}
+
+void
+CffWriter::write_encoding(StringAccum &sa)
+{
+    // Format 0 covers the leading run of encoded glyphs; every other code
+    // becomes a supplement.
+    Vector<int> primary(_gids.size(), -1);
+    for (int c = 0; c < 256; ++c) {
+        int g = _t1font->_encoding[c];
+        if (g > 0 && g < _gid_map.size() && _gid_map[g] > 0
+            && primary[_gid_map[g]] < 0)
+            primary[_gid_map[g]] = c;
+    }
+    int ncodes = 1;
+    while (ncodes < primary.size() && primary[ncodes] >= 0 && ncodes <= 255)
+        ++ncodes;
+    --ncodes;
+
+    Vector<int> supplements;
+    for (int c = 0; c < 256 && supplements.size() < 255; ++c) {
+        int g = _t1font->_encoding[c];
+        if (g > 0 && g < _gid_map.size() && _gid_map[g] > 0
+            && (_gid_map[g] > ncodes || primary[_gid_map[g]] != c))
+            supplements.push_back(c);
+    }
+
+    sa.append((char) (supplements.size() ? 0x80 : 0));
+    sa.append((char) ncodes);
+    for (int i = 1; i <= ncodes; ++i)
+        sa.append((char) primary[i]);
+    if (supplements.size()) {
+        sa.append((char) supplements.size());
+        for (int i = 0; i < supplements.size(); ++i) {
+            int c = supplements[i];
+            sa.append((char) c);
+            append_u16(sa, sid(_t1font->glyph_name(_t1font->_encoding[c])));
+        }
+    }
+}
+
+void
+CffWriter::write_fdselect(StringAccum &sa)
+{
+    // format 3
+    int nranges = 0;
+    for (int i = 0; i < _fds.size(); ++i)
+        if (i == 0 || _fds[i] != _fds[i - 1])
+            ++nranges;
+    sa.append((char) 3);
+    append_u16(sa, nranges);
+    for (int i = 0; i < _fds.size(); ++i)
+        if (i == 0 || _fds[i] != _fds[i - 1]) {
+            append_u16(sa, i);
+            sa.append((char) _fds[i]);
+        }
+    append_u16(sa, _fds.size());
+}
+
+String
+CffWriter::write()
+{
+    if (!_font->ok() || !_cff->ok()) {
+        _errh->error("invalid CFF");
+        return String();
+    } else if (_font->_charstring_type != 2) {
+        _errh->error("cannot write Type %d charstrings", _font->_charstring_type);
+        return String();
+    }
+    if (_gids.size() == 1)
+        for (int g = 1; g < _gid_map.size(); ++g)
+            add_glyph(g);
+    int nglyphs = _gids.size();
+
+    // Font DICTs
+    _fds.clear();
+    _fd_fonts.clear();
+    if (_cidfont) {
+        Vector<int> fd_map(_cidfont->_child_fonts.size(), -1);
+        for (int i = 0; i < nglyphs; ++i) {
+            int fd = _cidfont->_fdselect.gid_to_fd(_gids[i]);
+            if (fd < 0 || fd >= fd_map.size()) {
+                _errh->error("glyph %d has bad FDSelect", _gids[i]);
+                return String();
+            }
+            if (fd_map[fd] < 0) {
+                fd_map[fd] = _fd_fonts.size();
+                _fd_fonts.push_back(_cidfont->_child_fonts[fd]);
+            }
+            _fds.push_back(fd_map[fd]);
+        }
+    } else {
+        _fd_fonts.push_back(_t1font);
+        _fds.assign(nglyphs, 0);
+    }
+
+    // charstrings
+    _charstrings.assign(nglyphs, String());
+    for (int i = 0; i < nglyphs; ++i)
+        if (!flatten(_gids[i], _charstrings[i])) {
+            _errh->error("glyph %<%s%>: cannot expand subroutines", _font->glyph_name(_gids[i]).c_str());
+            return String();
+        }
+    _local_subrs.assign(_fd_fonts.size(), Vector<String>());
+    _global_subrs.clear();
+    if (_subroutinize)
+        subroutinize_charstrings();
+
+    // Private DICTs, each followed by its Subrs
+    Vector<String> privates;
+    Vector<int> private_sizes;
+    for (int fd = 0; fd < _fd_fonts.size(); ++fd) {
+        StringAccum sa;
+        write_dict(sa, _fd_fonts[fd]->_private_dict, false);
+        if (_local_subrs[fd].size()) {
+            append_dict_offset(sa, sa.length() + 6);
+            append_dict_operator(sa, Cff::oSubrs);
+        }
+        private_sizes.push_back(sa.length());
+        write_index(sa, _local_subrs[fd]);
+        privates.push_back(sa.take_string());
+    }
+
+    // Everything else depends on offsets, so lay out the file twice; the
+    // second pass produces DICTs of the same size.
+    _strings.clear();
+    _string_map.clear();
+    StringAccum header, name_index, charset, encoding, fdselect, charstrings_index;
+    header.append("\001\000\004\004", 4);
+    Vector<String> names;
+    names.push_back(String(_font->font_name()));
+    write_index(name_index, names);
+    write_charset(charset);
+    int encoding_pos = -1;
+    if (_t1font) {
+        encoding_pos = _t1font->_encoding_pos;
+        if (encoding_pos > 1)
+            write_encoding(encoding);
+    } else
+        write_fdselect(fdselect);
+    write_index(charstrings_index, _charstrings);
+
+    const Cff::Dict &top_dict = (_cidfont ? _cidfont->_top_dict : _t1font->_top_dict);
+    uint32_t charset_pos = 0, encoding_offset = 0, fdselect_pos = 0,
+        charstrings_pos = 0, fdarray_pos = 0, private_pos = 0;
+    String top_index, string_index, gsubr_index, fdarray_index;
+    for (int pass = 0; pass < 2; ++pass) {
+        StringAccum sa;
+        Vector<String> items;
+
+        // Top DICT
+        write_dict(sa, top_dict, true);
+        append_dict_offset(sa, charset_pos);
+        append_dict_operator(sa, Cff::oCharset);
+        if (encoding_pos > 1) {
+            append_dict_offset(sa, encoding_offset);
+            append_dict_operator(sa, Cff::oEncoding);
+        } else if (encoding_pos == 1) {
+            append_dict_number(sa, 1);
+            append_dict_operator(sa, Cff::oEncoding);
+        }
+        append_dict_offset(sa, charstrings_pos);
+        append_dict_operator(sa, Cff::oCharStrings);
+        if (_cidfont) {
+            append_dict_offset(sa, fdarray_pos);
+            append_dict_operator(sa, Cff::oFDArray);
+            append_dict_offset(sa, fdselect_pos);
+            append_dict_operator(sa, Cff::oFDSelect);
+        } else {
+            append_dict_offset(sa, private_sizes[0]);
+            append_dict_offset(sa, private_pos);
+            append_dict_operator(sa, Cff::oPrivate);
+        }
+        items.push_back(sa.take_string());
+        StringAccum top_sa;
+        write_index(top_sa, items);
+        top_index = top_sa.take_string();
+
+        // Font DICTs
+        if (_cidfont) {
+            items.clear();
+            uint32_t pos = private_pos;
+            for (int fd = 0; fd < _fd_fonts.size(); ++fd) {
+                write_dict(sa, _fd_fonts[fd]->_top_dict, false);
+                append_dict_offset(sa, private_sizes[fd]);
+                append_dict_offset(sa, pos);
+                append_dict_operator(sa, Cff::oPrivate);
+                items.push_back(sa.take_string());
+                pos += privates[fd].length();
+            }
+            StringAccum fdarray_sa;
+            write_index(fdarray_sa, items);
+            fdarray_index = fdarray_sa.take_string();
+        }
+
+        StringAccum string_sa, gsubr_sa;
+        write_index(string_sa, _strings);
+        string_index = string_sa.take_string();
+        write_index(gsubr_sa, _global_subrs);
+        gsubr_index = gsubr_sa.take_string();
+
+        uint32_t pos = header.length() + name_index.length() + top_index.length()
+            + string_index.length() + gsubr_index.length();
+        encoding_offset = pos;
+        pos += encoding.length();
+        charset_pos = pos;
+        pos += charset.length();
+        fdselect_pos = pos;
+        pos += fdselect.length();
+        charstrings_pos = pos;
+        pos += charstrings_index.length();
+        fdarray_pos = pos;
+        pos += fdarray_index.length();
+        private_pos = pos;
+    }
+
+    StringAccum out;
+    out << header << name_index << top_index << string_index << gsubr_index
+        << encoding << charset << fdselect << charstrings_index << fdarray_index;
+    for (int fd = 0; fd < privates.size(); ++fd)
+        out << privates[fd];
+    return out.take_string();
+}
+
+
+/*****
+ * OpenType wrapper
+ **/
+
+static String
+make_cmap(const Vector<std::pair<uint32_t, int> > &mapping)
+{
+    // format 4 for the BMP, plus format 12 if anything is outside it
+    StringAccum f4, f12;
+    Vector<std::pair<uint32_t, int> > segs;     // start code, length
+    bool need_f12 = false;
+    for (int i = 0; i < mapping.size(); ++i) {
+        uint32_t u = mapping[i].first;
+        if (u > 0xFFFF) {
+            need_f12 = true;
+            continue;
+        }
+        if (segs.size() && segs.back().first + segs.back().second == u
+            && mapping[i - 1].second + 1 == mapping[i].second)
+            segs.back().second++;
+        else
+            segs.push_back(std::make_pair(u, 1));
+    }
+    if (!segs.size() || segs.back().first + segs.back().second <= 0xFFFF)
+        segs.push_back(std::make_pair(0xFFFFU, 1));
+
+    int segcount = segs.size();
+    int entry_selector = 0;
+    while ((2 << entry_selector) <= segcount)
+        ++entry_selector;
+    append_u16(f4, 4);
+    append_u16(f4, 16 + 8 * segcount);
+    append_u16(f4, 0);
+    append_u16(f4, segcount * 2);
+    append_u16(f4, 2 << entry_selector);
+    append_u16(f4, entry_selector);
+    append_u16(f4, segcount * 2 - (2 << entry_selector));
+    for (int i = 0; i < segcount; ++i)
+        append_u16(f4, segs[i].first + segs[i].second - 1);
+    append_u16(f4, 0);
+    for (int i = 0; i < segcount; ++i)
+        append_u16(f4, segs[i].first);
+    for (int i = 0, m = 0; i < segcount; ++i) {
+        while (m < mapping.size() && mapping[m].first < segs[i].first)
+            ++m;
+        int gid = (m < mapping.size() && mapping[m].first == segs[i].first ? mapping[m].second : 0);
+        append_u16(f4, (gid - segs[i].first) & 0xFFFF);
+    }
+    for (int i = 0; i < segcount; ++i)
+        append_u16(f4, 0);
+    bool f4_ok = (f4.length() <= 0xFFFF);
+    if (!f4_ok)
+        need_f12 = true;
+
+    if (need_f12) {
+        Vector<std::pair<uint32_t, int> > groups;
+        for (int i = 0; i < mapping.size(); ++i)
+            if (groups.size()
+                && groups.back().first + groups.back().second == mapping[i].first
+                && mapping[i - 1].second + 1 == mapping[i].second)
+                groups.back().second++;
+            else
+                groups.push_back(std::make_pair(mapping[i].first, 1));
+        append_u16(f12, 12);
+        append_u16(f12, 0);
+        append_u32(f12, 16 + 12 * groups.size());
+        append_u32(f12, 0);
+        append_u32(f12, groups.size());
+        for (int i = 0, m = 0; i < groups.size(); ++i) {
+            append_u32(f12, groups[i].first);
+            append_u32(f12, groups[i].first + groups[i].second - 1);
+            append_u32(f12, mapping[m].second);
+            m += groups[i].second;
+        }
+    }
+
+    StringAccum sa;
+    int ntables = f4_ok + need_f12;
+    append_u16(sa, 0);
+    append_u16(sa, ntables);
+    uint32_t offset = 4 + 8 * ntables;
+    if (f4_ok) {
+        append_u16(sa, 3);
+        append_u16(sa, 1);
+        append_u32(sa, offset);
+        offset += f4.length();
+    }
+    if (need_f12) {
+        append_u16(sa, 3);
+        append_u16(sa, 10);
+        append_u32(sa, offset);
+    }
+    if (f4_ok)
+        sa << f4;
+    sa << f12;
+    return sa.take_string();
+}
+
+OpenType::Font
+CffWriter::make_otf(const OpenType::Font &otf, const String &cff,
+                    const Vector<int> &gids, ErrorHandler *errh)
+{
+    using namespace OpenType;
+    if (!errh)
+        errh = ErrorHandler::silent_handler();
+    Vector<Tag> tags;
+    Vector<String> tables;
+    int nglyphs = gids.size();
+
+    tags.push_back(Tag("CFF "));
+    tables.push_back(cff);
+
+    // copied tables
+    static const char * const copy_tables[] = { "head", "name", "OS/2", 0 };
+    for (const char * const *t = copy_tables; *t; ++t)
+        if (String s = otf.table(*t)) {
+            tags.push_back(Tag(*t));
+            tables.push_back(s);
+        }
+
+    // metrics
+    String hhea = otf.table("hhea"), hmtx = otf.table("hmtx");
+    if (hhea.length() >= 36) {
+        int nhmetrics = Data::u16(hhea.udata() + 34);
+        StringAccum hmtx_sa;
+        const uint8_t *hm = hmtx.udata();
+        for (int i = 0; i < nglyphs; ++i) {
+            int g = gids[i], aw = 0, lsb = 0;
+            if (nhmetrics > 0 && 4 * nhmetrics <= hmtx.length())
+                aw = Data::u16(hm + 4 * (g < nhmetrics ? g : nhmetrics - 1));
+            if (g < nhmetrics && 4 * g + 4 <= hmtx.length())
+                lsb = Data::u16(hm + 4 * g + 2);
+            else if (4 * nhmetrics + 2 * (g - nhmetrics) + 2 <= hmtx.length())
+                lsb = Data::u16(hm + 4 * nhmetrics + 2 * (g - nhmetrics));
+            append_u16(hmtx_sa, aw);
+            append_u16(hmtx_sa, lsb);
+        }
+        StringAccum hhea_sa;
+        hhea_sa << hhea.substring(0, 34);
+        append_u16(hhea_sa, nglyphs);
+        hhea_sa << hhea.substring(36);
+        tags.push_back(Tag("hhea"));
+        tables.push_back(hhea_sa.take_string());
+        tags.push_back(Tag("hmtx"));
+        tables.push_back(hmtx_sa.take_string());
+    } else
+        errh->warning("font has no %<hhea%> table");
+
+    StringAccum maxp;
+    append_u32(maxp, 0x00005000);
+    append_u16(maxp, nglyphs);
+    tags.push_back(Tag("maxp"));
+    tables.push_back(maxp.take_string());
+
+    String post = otf.table("post");
+    if (post.length() >= 32) {
+        StringAccum post_sa;
+        append_u32(post_sa, 0x00030000);
+        post_sa << post.substring(4, 28);
+        tags.push_back(Tag("post"));
+        tables.push_back(post_sa.take_string());
+    }
+
+    // cmap
+    if (String cmap_str = otf.table("cmap")) {
+        Cmap cmap(cmap_str, errh);
+        Vector<std::pair<uint32_t, Glyph> > ugp;
+        if (cmap.ok())
+            cmap.unmap_all(ugp);
+        Vector<int> gid_map;
+        for (int i = 0; i < nglyphs; ++i) {
+            if (gids[i] >= gid_map.size())
+                gid_map.resize(gids[i] + 1, -1);
+            gid_map[gids[i]] = i;
+        }
+        Vector<std::pair<uint32_t, int> > mapping;
+        for (int i = 0; i < ugp.size(); ++i)
+            if (ugp[i].second > 0 && ugp[i].second < gid_map.size()
+                && gid_map[ugp[i].second] > 0)
+                mapping.push_back(std::make_pair(ugp[i].first, gid_map[ugp[i].second]));
+        std::sort(mapping.begin(), mapping.end());
+        int n = 0;
+        for (int i = 0; i < mapping.size(); ++i)
+            if (n == 0 || mapping[i].first != mapping[n - 1].first)
+                mapping[n++] = mapping[i];
+        mapping.resize(n);
+        tags.push_back(Tag("cmap"));
+        tables.push_back(make_cmap(mapping));
+    }
+
+    return Font::make(false, tags, tables);
+}
+
+}
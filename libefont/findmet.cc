@@ -23,14 +23,20 @@
 #include <efont/psres.hh>
 #include <string.h>
 #include <stdlib.h>
+#if HAVE_DIRENT_H && !defined(WIN32)
+# include <dirent.h>
+#endif
 namespace Efont {
 
 MetricsFinder::~MetricsFinder()
 {
+    MetricsFinder *neighbor = (_prev ? _prev : _next);
     if (_next)
         _next->_prev = _prev;
     if (_prev)
         _prev->_next = _next;
+    if (neighbor)
+        neighbor->chain_changed();
 }
 
 void
@@ -42,9 +48,20 @@ MetricsFinder::add_finder(MetricsFinder *new_finder)
         assert(!new_finder->_prev);
         new_finder->_prev = this;
         _next = new_finder;
+        chain_changed();
     }
 }
 
+void
+MetricsFinder::chain_changed()
+{
+    MetricsFinder *f = this;
+    while (f->_prev)
+        f = f->_prev;
+    for (; f; f = f->_next)
+        f->finders_changed();
+}
+
 Metrics *
 MetricsFinder::find_metrics(PermString name, ErrorHandler *errh)
 {
@@ -52,8 +69,10 @@ MetricsFinder::find_metrics(PermString name, ErrorHandler *errh)
     while (f) {
         Metrics *m = f->find_metrics_x(name, this, errh);
         if (m) return m;
+        if (f->is_missing(name, false)) return 0;
         f = f->_next;
     }
+    record_missing(name, false);
     return 0;
 }
 
@@ -64,11 +83,25 @@ MetricsFinder::find_amfm(PermString name, ErrorHandler *errh)
     while (f) {
         AmfmMetrics *m = f->find_amfm_x(name, this, errh);
         if (m) return m;
+        if (f->is_missing(name, true)) return 0;
         f = f->_next;
     }
+    record_missing(name, true);
     return 0;
 }
 
+bool
+MetricsFinder::is_missing(PermString, bool) const
+{
+    return false;
+}
+
+void
+MetricsFinder::record_missing(PermString name, bool amfm)
+{
+    if (_next) _next->record_missing(name, amfm);
+}
+
 void
 MetricsFinder::record(Metrics *m)
 {
@@ -129,7 +162,7 @@ MetricsFinder::try_amfm_file(const Filename &fn, MetricsFinder *finder,
  **/
 
 CacheMetricsFinder::CacheMetricsFinder()
-    : _metrics_map(-1), _amfm_map(-1)
+    : _metrics_map(-1), _amfm_map(-1), _missing_metrics(0), _missing_amfm(0)
 {
 }
 
@@ -161,6 +194,7 @@ CacheMetricsFinder::record(Metrics *m, PermString name)
     int index = _metrics.size();
     _metrics.push_back(m);
     _metrics_map.insert(name, index);
+    _missing_metrics.insert(name, 0);
     m->use();
     MetricsFinder::record(m, name);
 }
@@ -171,10 +205,32 @@ CacheMetricsFinder::record(AmfmMetrics *amfm)
     int index = _amfm.size();
     _amfm.push_back(amfm);
     _amfm_map.insert(amfm->font_name(), index);
+    _missing_amfm.insert(amfm->font_name(), 0);
     amfm->use();
     MetricsFinder::record(amfm);
 }
 
+bool
+CacheMetricsFinder::is_missing(PermString name, bool amfm) const
+{
+    return (amfm ? _missing_amfm : _missing_metrics)[name] != 0;
+}
+
+void
+CacheMetricsFinder::record_missing(PermString name, bool amfm)
+{
+    (amfm ? _missing_amfm : _missing_metrics).insert(name, 1);
+    MetricsFinder::record_missing(name, amfm);
+}
+
+void
+CacheMetricsFinder::finders_changed()
+{
+    // a new finder might find what the old chain could not
+    _missing_metrics.clear();
+    _missing_amfm.clear();
+}
+
 void
 CacheMetricsFinder::clear()
 {
@@ -186,6 +242,8 @@ CacheMetricsFinder::clear()
     _amfm.clear();
     _metrics_map.clear();
     _amfm_map.clear();
+    _missing_metrics.clear();
+    _missing_amfm.clear();
 }
 
 
@@ -194,7 +252,7 @@ CacheMetricsFinder::clear()
  **/
 
 InstanceMetricsFinder::InstanceMetricsFinder(bool call_mmpfb)
-    : _call_mmpfb(call_mmpfb)
+    : _call_mmpfb(call_mmpfb), _mmpfb_tried(0)
 {
 }
 
@@ -210,7 +268,10 @@ InstanceMetricsFinder::find_metrics_instance(PermString name,
     if (!amfm) return 0;
 
     MultipleMasterSpace *mmspace = amfm->mmspace();
-    if (!mmspace->check_intermediate() && _call_mmpfb) {
+    if (!mmspace->check_intermediate() && _call_mmpfb
+        && !_mmpfb_tried[amfm->font_name()]) {
+        // run mmpfb at most once per font, even if it fails
+        _mmpfb_tried.insert(amfm->font_name(), 1);
         size_t bufsz = amfm->font_name().length() + 30;
         char *buf = new char[bufsz];
         snprintf(buf, bufsz, "mmpfb -q --amcp-info '%s'", amfm->font_name().c_str());
@@ -291,17 +352,37 @@ PsresMetricsFinder::find_amfm_x(PermString name, MetricsFinder *finder,
  **/
 
 DirectoryMetricsFinder::DirectoryMetricsFinder(PermString d)
-    : _directory(d)
+    : _directory(d), _listed(false), _listing_ok(false), _files(0)
 {
 }
 
+bool
+DirectoryMetricsFinder::maybe_exists(PermString name, const char *suffix)
+{
+    // List the directory once, rather than probing it for every name.
+#if HAVE_DIRENT_H && !defined(WIN32)
+    if (!_listed) {
+        _listed = true;
+        if (DIR *dir = opendir(_directory.c_str())) {
+            _listing_ok = true;
+            while (struct dirent *dirent = readdir(dir))
+                _files.insert(PermString(dirent->d_name), 1);
+            closedir(dir);
+        }
+    }
+#endif
+    return !_listing_ok || _files[permcat(name, suffix)];
+}
+
 Metrics *
 DirectoryMetricsFinder::find_metrics_x(PermString name, MetricsFinder *finder,
                                        ErrorHandler *errh)
 {
-    Metrics *afm = try_metrics_file
-        (Filename(_directory, permcat(name, ".afm")), finder, errh);
-    if (!afm)
+    Metrics *afm = 0;
+    if (maybe_exists(name, ".afm"))
+        afm = try_metrics_file
+            (Filename(_directory, permcat(name, ".afm")), finder, errh);
+    if (!afm && maybe_exists(name, ".AFM"))
         afm = try_metrics_file
             (Filename(_directory, permcat(name, ".AFM")), finder, errh);
     return afm;
@@ -311,9 +392,11 @@ AmfmMetrics *
 DirectoryMetricsFinder::find_amfm_x(PermString name, MetricsFinder *finder,
                                     ErrorHandler *errh)
 {
-    AmfmMetrics *amfm = try_amfm_file
-        (Filename(_directory, permcat(name, ".amfm")), finder, errh);
-    if (!amfm)
+    AmfmMetrics *amfm = 0;
+    if (maybe_exists(name, ".amfm"))
+        amfm = try_amfm_file
+            (Filename(_directory, permcat(name, ".amfm")), finder, errh);
+    if (!amfm && maybe_exists(name, ".AMFM"))
         amfm = try_amfm_file
             (Filename(_directory, permcat(name, ".AMFM")), finder, errh);
     return amfm;
@@ -0,0 +1,491 @@
+// -*- related-file-name: "../include/efont/fontindex.hh" -*-
+
+/* fontindex.{cc,hh} -- persistent OpenType font metadata index
+ *
+ * Copyright (c) 2026 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <efont/fontindex.hh>
+#include <efont/otfname.hh>
+#include <efont/otfos2.hh>
+#include <efont/otfgsub.hh>
+#include <efont/otfgpos.hh>
+#include <lcdf/error.hh>
+#include <lcdf/straccum.hh>
+#include <lcdf/cachefile.hh>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+# include <unistd.h>
+#endif
+#if HAVE_DIRENT_H && !defined(WIN32)
+# include <dirent.h>
+#endif
+namespace Efont {
+
+/* Index file format:
+
+     "FNTIDX01" nentries
+     { filename size mtime postscript_name family style version
+       nscripts { script } nfeatures { tag } optical_min optical_max
+       ntables { tag checksum } }
+
+   The encoding is described in <lcdf/cachefile.hh>. Optical sizes are in
+   thousandths of a point. */
+
+static const char index_magic[] = "FNTIDX01";
+
+namespace {
+struct IndexReader : public CacheReader {
+    using CacheReader::get;
+    bool get(unsigned long long &x) {
+        return get64(x);
+    }
+    bool get(PermString &str) {
+        String x;
+        if (!get(x))
+            return false;
+        str = (x ? PermString(x) : PermString());
+        return true;
+    }
+    bool get(OpenType::Tag &tag) {
+        uint32_t x;
+        if (!get(x))
+            return false;
+        tag = OpenType::Tag(x);
+        return true;
+    }
+};
+}
+
+FontIndex::FontIndex()
+    : _file_map(-1), _sorted(false)
+{
+}
+
+bool
+FontIndex::read(const String &filename, ErrorHandler *errh)
+{
+    LocalErrorHandler lerrh(errh);
+    IndexReader r;
+    if (!r.read(filename, &lerrh))
+        return false;
+
+    String str;
+    uint32_t n, m, optmin, optmax;
+    if (!r.get(str) || str != index_magic || !r.get(n)) {
+        lerrh.error("%s: not a font index", filename.c_str());
+        return false;
+    }
+
+    // bound each list length by the bytes left, so a damaged index cannot
+    // request huge allocations
+    Vector<Entry> entries;
+    for (uint32_t i = 0; i < n; i++) {
+        Entry e;
+        if (!r.get(e.filename) || !r.get(e.size) || !r.get(e.mtime)
+            || !r.get(e.postscript_name) || !r.get(e.family)
+            || !r.get(e.style) || !r.get(e.version) || !r.get_count(m, 4))
+            goto corrupt;
+        e.scripts.resize(m);
+        for (uint32_t j = 0; j < m; j++)
+            if (!r.get(e.scripts[j]))
+                goto corrupt;
+        if (!r.get_count(m, 4))
+            goto corrupt;
+        e.features.resize(m);
+        for (uint32_t j = 0; j < m; j++)
+            if (!r.get(e.features[j]))
+                goto corrupt;
+        if (!r.get(optmin) || !r.get(optmax) || !r.get_count(m, 8))
+            goto corrupt;
+        e.optical_min = optmin / 1000.;
+        e.optical_max = optmax / 1000.;
+        e.tables.resize(m);
+        e.table_checksums.resize(m);
+        for (uint32_t j = 0; j < m; j++)
+            if (!r.get(e.tables[j]) || !r.get(e.table_checksums[j]))
+                goto corrupt;
+        entries.push_back(std::move(e));
+    }
+    if (!r.done())
+        goto corrupt;
+
+    _entries.swap(entries);
+    rebuild_file_map();
+    return true;
+
+  corrupt:
+    lerrh.error("%s: font index corrupted", filename.c_str());
+    return false;
+}
+
+bool
+FontIndex::write(const String &filename, ErrorHandler *errh) const
+{
+    CacheWriter w;
+    w.put(String(index_magic));
+    w.put(_entries.size());
+    for (const Entry *e = _entries.begin(); e != _entries.end(); ++e) {
+        w.put(e->filename);
+        w.put64(e->size);
+        w.put64(e->mtime);
+        w.put(String(e->postscript_name));
+        w.put(String(e->family));
+        w.put(String(e->style));
+        w.put(e->version);
+        w.put(e->scripts.size());
+        for (const String *sp = e->scripts.begin(); sp != e->scripts.end(); ++sp)
+            w.put(*sp);
+        w.put(e->features.size());
+        for (const OpenType::Tag *tp = e->features.begin(); tp != e->features.end(); ++tp)
+            w.put(tp->value());
+        w.put((uint32_t) (e->optical_min * 1000 + 0.5));
+        w.put((uint32_t) (e->optical_max * 1000 + 0.5));
+        w.put(e->tables.size());
+        for (int i = 0; i < e->tables.size(); ++i) {
+            w.put(e->tables[i].value());
+            w.put(e->table_checksums[i]);
+        }
+    }
+    return w.write(filename, false, errh);
+}
+
+static void
+collect_layout_x(const OpenType::ScriptList &script_list,
+                 const OpenType::FeatureList &feature_list,
+                 Vector<String> &scripts, Vector<OpenType::Tag> &features,
+                 ErrorHandler *errh)
+{
+    Vector<OpenType::Tag> script, langsys;
+    script_list.language_systems(script, langsys, errh);
+    for (int i = 0; i < script.size(); i++) {
+        scripts.push_back(OpenType::Tag::langsys_text(script[i], langsys[i]));
+        int required_fid;
+        Vector<int> fids;
+        script_list.features(script[i], langsys[i], required_fid, fids, errh);
+        if (required_fid >= 0)
+            fids.push_back(required_fid);
+        for (int *fidp = fids.begin(); fidp != fids.end(); ++fidp)
+            features.push_back(feature_list.tag(*fidp));
+    }
+}
+
+template <typename T> static void
+sort_unique(Vector<T> &v)
+{
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+void
+FontIndex::collect_layout(const OpenType::Font &otf, Vector<String> &scripts,
+                          Vector<OpenType::Tag> &features, ErrorHandler *errh)
+{
+    scripts.clear();
+    features.clear();
+    try {
+        if (String gsub_table = otf.table("GSUB")) {
+            OpenType::Gsub gsub(gsub_table, &otf, errh);
+            collect_layout_x(gsub.script_list(), gsub.feature_list(), scripts, features, errh);
+        }
+    } catch (OpenType::Error) {
+    }
+    try {
+        if (String gpos_table = otf.table("GPOS")) {
+            OpenType::Gpos gpos(gpos_table, errh);
+            collect_layout_x(gpos.script_list(), gpos.feature_list(), scripts, features, errh);
+        }
+    } catch (OpenType::Error) {
+    }
+    sort_unique(scripts);
+    sort_unique(features);
+}
+
+bool
+FontIndex::parse_font(Entry &e, const String &data, ErrorHandler *errh)
+{
+    OpenType::Font otf(data, errh);
+    if (!otf.ok())
+        return false;
+
+    e.postscript_name = e.family = e.style = PermString();
+    e.version = String();
+    e.scripts.clear();
+    e.features.clear();
+    e.optical_min = e.optical_max = 0;
+    e.tables.clear();
+    e.table_checksums.clear();
+
+    try {
+        if (String name_table = otf.table("name")) {
+            OpenType::Name name(name_table, errh);
+            if (name.ok()) {
+                e.postscript_name = name.english_name(OpenType::Name::N_POSTSCRIPT);
+                String s = name.english_name(OpenType::Name::N_PREF_FAMILY);
+                e.family = (s ? s : name.english_name(OpenType::Name::N_FAMILY));
+                s = name.english_name(OpenType::Name::N_PREF_SUBFAMILY);
+                e.style = (s ? s : name.english_name(OpenType::Name::N_SUBFAMILY));
+                e.version = name.english_name(OpenType::Name::N_VERSION);
+            }
+        }
+    } catch (OpenType::Error) {
+    }
+
+    collect_layout(otf, e.scripts, e.features, errh);
+
+    try {
+        if (String os2_table = otf.table("OS/2")) {
+            OpenType::Os2 os2(os2_table, errh);
+            if (os2.ok() && os2.has_optical_point_size()) {
+                e.optical_min = os2.lower_optical_point_size();
+                e.optical_max = os2.upper_optical_point_size();
+            }
+        }
+    } catch (OpenType::Error) {
+    }
+
+    for (int i = 0; i < otf.ntables(); i++)
+        if (OpenType::Tag tag = otf.table_tag(i)) {
+            e.tables.push_back(tag);
+            e.table_checksums.push_back(otf.table_checksum(tag));
+        }
+    return true;
+}
+
+// Index entries are looked up from other directories, so record fonts by
+// absolute file name.
+static String
+absolute_filename(const String &filename)
+{
+#ifndef WIN32
+    char cwd[4096];
+    if (filename && filename[0] != '/' && getcwd(cwd, sizeof(cwd))) {
+        String rest = filename;
+        while (rest.starts_with("./"))
+            rest = rest.substring(2);
+        StringAccum sa;
+        sa << cwd;
+        if (sa.back() != '/')
+            sa << '/';
+        sa << rest;
+        return sa.take_string();
+    }
+#endif
+    return filename;
+}
+
+bool
+FontIndex::add_font(const String &name, ErrorHandler *errh)
+{
+    String filename = absolute_filename(name);
+    LocalErrorHandler lerrh(errh);
+    struct stat st;
+    if (stat(filename.c_str(), &st) < 0) {
+        lerrh.error("%s: %s", filename.c_str(), strerror(errno));
+        return false;
+    }
+    unsigned long long size = st.st_size, mtime = st.st_mtime;
+
+    int i = _file_map[filename];
+    if (i >= 0 && _entries[i].size == size && _entries[i].mtime == mtime)
+        return true;
+
+    int before_nerrors = lerrh.nerrors();
+    String data = read_whole_file(filename, &lerrh);
+    if (lerrh.nerrors() != before_nerrors)
+        return false;
+    Entry e;
+    e.filename = filename;
+    e.size = size;
+    e.mtime = mtime;
+    LandmarkErrorHandler cerrh(&lerrh, filename);
+    if (!parse_font(e, data, &cerrh))
+        return false;
+
+    if (i >= 0)
+        _entries[i] = std::move(e);
+    else {
+        _file_map.insert(filename, _entries.size());
+        _entries.push_back(std::move(e));
+    }
+    _sorted = false;
+    return true;
+}
+
+#if HAVE_DIRENT_H && !defined(WIN32)
+// Symbolic links can make directory cycles, so find_fonts visits each
+// directory, identified by device and inode, only once.
+static String
+directory_id(const struct stat &st)
+{
+    StringAccum sa;
+    sa << (unsigned long) st.st_dev << '/' << (unsigned long) st.st_ino;
+    return sa.take_string();
+}
+
+static void
+find_fonts_x(const String &directory, Vector<String> &filenames, HashMap<String, int> &visited, ErrorHandler *errh)
+{
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) {
+        LocalErrorHandler(errh).error("%s: %s", directory.c_str(), strerror(errno));
+        return;
+    }
+    Vector<String> names;
+    while (struct dirent *dirent = readdir(dir))
+        if (dirent->d_name[0] != '.')
+            names.push_back(dirent->d_name);
+    closedir(dir);
+
+    // visit entries in a stable order
+    std::sort(names.begin(), names.end());
+    String prefix = (directory.back() == '/' ? directory : directory + "/");
+    for (String *np = names.begin(); np != names.end(); ++np) {
+        String path = prefix + *np;
+        struct stat st;
+        if (stat(path.c_str(), &st) < 0)
+            continue;
+        if (S_ISDIR(st.st_mode)) {
+            if (visited.insert(directory_id(st), 1))
+                find_fonts_x(path, filenames, visited, errh);
+        } else if (FontIndex::is_font_filename(*np))
+            filenames.push_back(path);
+    }
+}
+#endif
+
+void
+FontIndex::find_fonts(const String &directory, Vector<String> &filenames, ErrorHandler *errh)
+{
+#if HAVE_DIRENT_H && !defined(WIN32)
+    HashMap<String, int> visited(0);
+    struct stat st;
+    if (stat(directory.c_str(), &st) == 0)
+        visited.insert(directory_id(st), 1);
+    find_fonts_x(directory, filenames, visited, errh);
+#else
+    (void) filenames;
+    LocalErrorHandler(errh).error("%s: cannot list directories", directory.c_str());
+#endif
+}
+
+bool
+FontIndex::is_font_filename(const String &name)
+{
+    if (name.length() < 4 || name[name.length() - 4] != '.')
+        return false;
+    String ext = name.substring(-3).lower();
+    return ext == "otf" || ext == "ttf";
+}
+
+int
+FontIndex::refresh(ErrorHandler *errh)
+{
+    // drop vanished files, then reparse files that changed
+    Entry *out = _entries.begin();
+    for (Entry *e = _entries.begin(); e != _entries.end(); ++e) {
+        struct stat st;
+        if (stat(e->filename.c_str(), &st) < 0)
+            continue;
+        if (out != e)
+            *out = std::move(*e);
+        ++out;
+    }
+    int nchanged = _entries.end() - out;
+    if (nchanged) {
+        _entries.erase(out, _entries.end());
+        rebuild_file_map();
+    }
+
+    for (int i = 0; i < _entries.size(); i++) {
+        unsigned long long size = _entries[i].size, mtime = _entries[i].mtime;
+        String filename = _entries[i].filename;
+        add_font(filename, errh);
+        if (_entries[i].size != size || _entries[i].mtime != mtime)
+            nchanged++;
+    }
+    return nchanged;
+}
+
+void
+FontIndex::rebuild_file_map()
+{
+    _file_map.clear();
+    for (int i = 0; i < _entries.size(); i++)
+        _file_map.insert(_entries[i].filename, i);
+    _sorted = false;
+}
+
+void
+FontIndex::sort() const
+{
+    _by_name.clear();
+    _by_family.clear();
+    _by_feature.clear();
+    for (int i = 0; i < _entries.size(); i++) {
+        const Entry &e = _entries[i];
+        if (e.postscript_name)
+            _by_name.push_back(std::make_pair(e.postscript_name, i));
+        if (e.family)
+            _by_family.push_back(std::make_pair(e.family, i));
+        for (const OpenType::Tag *tp = e.features.begin(); tp != e.features.end(); ++tp)
+            _by_feature.push_back(std::make_pair(*tp, i));
+    }
+    // PermStrings are unique, so ordering them by address is enough
+    std::sort(_by_name.begin(), _by_name.end());
+    std::sort(_by_family.begin(), _by_family.end());
+    std::sort(_by_feature.begin(), _by_feature.end());
+    _sorted = true;
+}
+
+int
+FontIndex::find_postscript_name(PermString name) const
+{
+    if (!_sorted)
+        sort();
+    std::pair<PermString, int> *p =
+        std::lower_bound(_by_name.begin(), _by_name.end(), std::make_pair(name, -1));
+    return p != _by_name.end() && p->first == name ? p->second : -1;
+}
+
+void
+FontIndex::find_family(PermString family, Vector<int> &result) const
+{
+    if (!_sorted)
+        sort();
+    result.clear();
+    std::pair<PermString, int> *p =
+        std::lower_bound(_by_family.begin(), _by_family.end(), std::make_pair(family, -1));
+    for (; p != _by_family.end() && p->first == family; ++p)
+        result.push_back(p->second);
+}
+
+void
+FontIndex::find_feature(OpenType::Tag feature, Vector<int> &result) const
+{
+    if (!_sorted)
+        sort();
+    result.clear();
+    std::pair<OpenType::Tag, int> *p =
+        std::lower_bound(_by_feature.begin(), _by_feature.end(), std::make_pair(feature, -1));
+    for (; p != _by_feature.end() && p->first == feature; ++p)
+        result.push_back(p->second);
+}
+
+}
@@ -18,6 +18,7 @@
 #endif
 #include <efont/metrics.hh>
 #include <efont/t1cs.hh>        /* for UNKDOUBLE */
+#include <math.h>
 namespace Efont {
 
 Metrics::Metrics()
@@ -113,7 +114,171 @@ Metrics::interpolate_dimens(const Metrics &m, double scale, bool increment)
   set_dimen(_rtv, m._rtv, scale, increment);
   set_dimen(_tpv, m._tpv, scale, increment);
   set_dimen(_btv, m._btv, scale, increment);
-  set_dimen(_kernv, m._kernv, scale, increment);
+  interpolate_kerns(m, scale, increment);
+}
+
+bool
+Metrics::kerns_aligned(const Metrics &m) const
+{
+  // Usually the masters list their kerns in the same order, and kern
+  // values correspond by index.
+  const PairProgram &mpairp = m._pairp;
+  int nops = _pairp.op_count();
+  if (nops != mpairp.op_count() || _kernv.size() != m._kernv.size())
+    return false;
+  for (PairOpIndex opi = 0; opi < nops; opi++) {
+    const PairOp &a = _pairp.op(opi), &b = mpairp.op(opi);
+    if (a.left() != b.left() || a.right() != b.right()
+        || a.is_kern() != b.is_kern()
+        || (a.is_kern() && a.value() != b.value()))
+      return false;
+  }
+  return true;
+}
+
+void
+Metrics::matched_kerns(const Metrics &m, Vector<double> &v) const
+{
+  // Otherwise, match each kern by its glyphs.
+  const PairProgram &mpairp = m._pairp;
+  v.assign(_kernv.size(), 0);
+  for (PairOpIndex opi = 0; opi < _pairp.op_count(); opi++) {
+    const PairOp &op = _pairp.op(opi);
+    if (op.is_kern()) {
+      PairOpIndex mopi = mpairp.find_kern(op.left(), op.right());
+      if (mopi >= 0)
+        v[op.value()] = m._kernv[mpairp.op(mopi).value()];
+    }
+  }
+}
+
+void
+Metrics::interpolate_kerns(const Metrics &m, double scale, bool increment)
+{
+  if (kerns_aligned(m))
+    set_dimen(_kernv, m._kernv, scale, increment);
+  else {
+    Vector<double> v;
+    matched_kerns(m, v);
+    set_dimen(_kernv, v, scale, increment);
+  }
+}
+
+static void
+blend_dimens(const Vector<const double *> &src, int n,
+             const double *weights, int nmasters,
+             const Vector<double *> &dst)
+{
+  // Work through the values in blocks, so that each block of the masters'
+  // values stays in cache while it is blended into every instance. Each
+  // value is summed in the same order as by interpolate_dimens().
+  enum { block = 512 };
+  for (int j0 = 0; j0 < n; j0 += block) {
+    int j1 = (j0 + block < n ? j0 + block : n);
+    for (int i = 0; i < dst.size(); i++) {
+      const double *w = weights + i * nmasters;
+      double *d = dst[i];
+      bool first = true;
+      for (int m = 0; m < nmasters; m++) {
+        double scale = w[m];
+        if (!scale)
+          continue;
+        const double *s = src[m];
+        if (!first)
+          for (int j = j0; j < j1; j++)
+            d[j] += s[j] * scale;
+        else if (scale < 0.9999 || scale > 1.0001)
+          for (int j = j0; j < j1; j++)
+            d[j] = s[j] * scale;
+        else
+          for (int j = j0; j < j1; j++)
+            d[j] = s[j];
+        first = false;
+      }
+    }
+  }
+}
+
+void
+Metrics::interpolate_dimens(const Vector<const Metrics *> &masters,
+                            const Vector<double> &weights,
+                            const Vector<Metrics *> &instances)
+{
+  // 'weights' holds one row of masters.size() weights per instance. Every
+  // instance must have been created from the same master, and masters
+  // with zero weight in every row may be null.
+  if (!instances.size())
+    return;
+  int nmasters = masters.size();
+  const Metrics *model = instances[0];
+  assert(weights.size() == instances.size() * nmasters);
+
+  Vector<Vector<double> > matched(nmasters, Vector<double>());
+  Vector<const double *> src(nmasters, (const double *) 0);
+  Vector<double *> dst(instances.size(), (double *) 0);
+
+  Vector<double> Metrics::*fields[] = {
+    &Metrics::_fdv, &Metrics::_wdv, &Metrics::_lfv, &Metrics::_rtv,
+    &Metrics::_tpv, &Metrics::_btv, &Metrics::_kernv
+  };
+  for (int f = 0; f < (int) (sizeof(fields) / sizeof(fields[0])); f++) {
+    Vector<double> Metrics::*field = fields[f];
+    int n = (model->*field).size();
+    for (int m = 0; m < nmasters; m++)
+      if (masters[m]) {
+        const Vector<double> *v = &(masters[m]->*field);
+        if (field == &Metrics::_kernv && !model->kerns_aligned(*masters[m])) {
+          model->matched_kerns(*masters[m], matched[m]);
+          v = &matched[m];
+        }
+        src[m] = v->begin();
+        if (v->size() < n)
+          n = v->size();
+      }
+    for (int i = 0; i < instances.size(); i++)
+      dst[i] = (instances[i]->*field).begin();
+    blend_dimens(src, n, weights.begin(), nmasters, dst);
+  }
+}
+
+static inline void
+pround(double &v, double multiplier, double divider)
+{
+  if (KNOWN(v))
+    v = floor(v * multiplier + 0.5) * divider;
+}
+
+void
+Metrics::round_dimens(int precision)
+{
+  if (precision < 0)
+    return;
+
+  double multiplier = 1, divider = 1;
+  for (int i = 0; i < precision; i++)
+    multiplier *= 10, divider /= 10;
+
+  for (int i = 0; i < _fdv.size(); i++)
+    pround(_fdv[i], multiplier, divider);
+
+  for (int i = 0; i < _wdv.size(); i++) {
+    pround(_wdv[i], multiplier, divider);
+    pround(_lfv[i], multiplier, divider);
+    pround(_btv[i], multiplier, divider);
+    pround(_rtv[i], multiplier, divider);
+    pround(_tpv[i], multiplier, divider);
+  }
+
+  for (int i = 0; i < _kernv.size(); i++)
+    pround(_kernv[i], multiplier, divider);
+}
+
+void
+Metrics::zero_small_kerns(double min_kern)
+{
+  for (int i = 0; i < _kernv.size(); i++)
+    if (fabs(_kernv[i]) < min_kern)
+      _kernv[i] = 0;
 }
 
 
@@ -189,8 +189,8 @@ class TagCompar { public:
 };
 }
 
-Font
-Font::make(bool truetype, const Vector<Tag>& tags, const Vector<String>& data)
+String
+Font::make_directory(bool truetype, const Vector<Tag>& tags, const Vector<String>& data, Vector<int>* order)
 {
     StringAccum sa;
 
@@ -239,6 +239,18 @@ Font::make(bool truetype, const Vector<Tag>& tags, const Vector<String>& data)
         offset += (data[*tp].length() + 3) & ~3;
     }
 
+    if (order)
+        order->swap(permut);
+    return sa.take_string();
+}
+
+Font
+Font::make(bool truetype, const Vector<Tag>& tags, const Vector<String>& data)
+{
+    Vector<int> permut;
+    StringAccum sa;
+    sa << make_directory(truetype, tags, data, &permut);
+
     // actual tables
     for (int *tp = permut.begin(); tp < permut.end(); tp++) {
         sa << data[*tp];
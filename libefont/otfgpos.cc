@@ -168,12 +168,12 @@ GposSingle::unparse(Vector<Positioning> &v) const
         int format = _d.u16(4);
         Data value = _d.subtable(6);
         for (Coverage::iterator i = coverage().begin(); i; i++)
-            v.push_back(Positioning(Position(*i, format, value)));
+            v.emplace_back(Position(*i, format, value));
     } else {
         int format = _d.u16(4);
         int size = GposValue::size(format);
         for (Coverage::iterator i = coverage().begin(); i; i++)
-            v.push_back(Positioning(Position(*i, format, _d.subtable(F2_HEADERSIZE + size*i.coverage_index()))));
+            v.emplace_back(Position(*i, format, _d.subtable(F2_HEADERSIZE + size*i.coverage_index())));
     }
 }
 
@@ -236,7 +236,7 @@ GposPair::unparse(Vector<Positioning> &v) const
                 if (p1 || p2) {
                     for (ClassDef::class_iterator c1i = class1.begin(c1, coverage); c1i; c1i++)
                         for (ClassDef::class_iterator c2i = class2.begin(c2); c2i; c2i++)
-                            v.push_back(Positioning(Position(*c1i, p1), Position(*c2i, p2)));
+                            v.emplace_back(Position(*c1i, p1), Position(*c2i, p2));
                 }
             }
     }
@@ -120,7 +120,8 @@ Substitution::Substitution(const Substitution &o)
 }
 
 Substitution::Substitution(Glyph in, Glyph out)
-    : _left_is(T_NONE), _in_is(T_GLYPH), _out_is(T_GLYPH), _right_is(T_NONE)
+    : _left_is(T_NONE), _in_is(T_GLYPH), _out_is(T_GLYPH), _right_is(T_NONE),
+      _alternate(false)
 {
     _in.gid = in;
     _out.gid = out;
@@ -136,7 +137,8 @@ Substitution::Substitution(Glyph in, const Vector<Glyph> &out, bool is_alternate
 }
 
 Substitution::Substitution(Glyph in1, Glyph in2, Glyph out)
-    : _left_is(T_NONE), _in_is(T_GLYPHS), _out_is(T_GLYPH), _right_is(T_NONE)
+    : _left_is(T_NONE), _in_is(T_GLYPHS), _out_is(T_GLYPH), _right_is(T_NONE),
+      _alternate(false)
 {
     _in.gids = new Glyph[3];
     _in.gids[0] = 2;
@@ -146,7 +148,8 @@ Substitution::Substitution(Glyph in1, Glyph in2, Glyph out)
 }
 
 Substitution::Substitution(const Vector<Glyph> &in, Glyph out)
-    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_GLYPH), _right_is(T_NONE)
+    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_GLYPH), _right_is(T_NONE),
+      _alternate(false)
 {
     assert(in.size() > 0);
     assign(_in, _in_is, in.size(), &in[0]);
@@ -154,7 +157,8 @@ Substitution::Substitution(const Vector<Glyph> &in, Glyph out)
 }
 
 Substitution::Substitution(int nin, const Glyph *in, Glyph out)
-    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_GLYPH), _right_is(T_NONE)
+    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_GLYPH), _right_is(T_NONE),
+      _alternate(false)
 {
     assert(nin > 0);
     assign(_in, _in_is, nin, in);
@@ -162,7 +166,8 @@ Substitution::Substitution(int nin, const Glyph *in, Glyph out)
 }
 
 Substitution::Substitution(int nleft, int nin, int nout, int nright)
-    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_NONE), _right_is(T_NONE)
+    : _left_is(T_NONE), _in_is(T_NONE), _out_is(T_NONE), _right_is(T_NONE),
+      _alternate(false)
 {
     if (nleft)
         assign_space(_left, _left_is, nleft);
@@ -193,6 +198,23 @@ Substitution::operator=(const Substitution &o)
     return *this;
 }
 
+Substitution &
+Substitution::operator=(Substitution &&o)
+{
+    if (&o != this) {
+        clear(_left, _left_is);
+        clear(_in, _in_is);
+        clear(_out, _out_is);
+        clear(_right, _right_is);
+        transfer(_left, _left_is, o._left, o._left_is);
+        transfer(_in, _in_is, o._in, o._in_is);
+        transfer(_out, _out_is, o._out, o._out_is);
+        transfer(_right, _right_is, o._right, o._right_is);
+        _alternate = o._alternate;
+    }
+    return *this;
+}
+
 bool
 Substitution::substitute_in(const Substitute &s, uint8_t t, const Coverage &c)
 {
@@ -829,11 +851,11 @@ GsubSingle::unparse(Vector<Substitution> &v, const Coverage &limit) const
         int delta = _d.s16(4);
         for (Coverage::iterator it = coverage().begin(); it; ++it)
             if (limit.covers(*it))
-                v.push_back(Substitution(*it, *it + delta));
+                v.emplace_back(*it, *it + delta);
     } else {
         for (Coverage::iterator it = coverage().begin(); it; ++it)
             if (limit.covers(*it))
-                v.push_back(Substitution(*it, _d.u16(HEADERSIZE + it.coverage_index()*FORMAT2_RECSIZE)));
+                v.emplace_back(*it, _d.u16(HEADERSIZE + it.coverage_index()*FORMAT2_RECSIZE));
     }
 }
 
@@ -909,7 +931,7 @@ GsubMultiple::unparse(Vector<Substitution> &v, bool is_alternate) const
         result.clear();
         for (int j = 0; j < seq.u16(0); j++)
             result.push_back(seq.u16(SEQ_HEADERSIZE + j*SEQ_RECSIZE));
-        v.push_back(Substitution(*i, result, is_alternate));
+        v.emplace_back(*i, result, is_alternate);
     }
 }
 
@@ -1006,7 +1028,7 @@ GsubLigature::unparse(Vector<Substitution> &v) const
             components.resize(1);
             for (int k = 0; k < nlig - 1; k++)
                 components.push_back(lig.u16(LIG_HEADERSIZE + k*LIG_RECSIZE));
-            v.push_back(Substitution(components, lig.u16(0)));
+            v.emplace_back(components, lig.u16(0));
         }
     }
 }
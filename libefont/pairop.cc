@@ -18,12 +18,14 @@
 #endif
 #include <efont/pairop.hh>
 #include <stdio.h>
+#include <algorithm>
 namespace Efont {
 
 PairProgram::PairProgram(const PairProgram &o)
-  : _reversed(o._reversed),
+  : _reversed(o._reversed), _frozen(o._frozen),
     _left_map(o._left_map),
-    _op(o._op)
+    _op(o._op),
+    _csr_first(o._csr_first), _csr_right(o._csr_right), _csr_op(o._csr_op)
 {
 }
 
@@ -33,15 +35,26 @@ PairProgram::reserve_glyphs(int e)
 {
   if (e <= _left_map.size()) return;
   _left_map.resize(e, -1);
+  _frozen = false;
 }
 
 
 PairOpIndex
-PairProgram::find(GlyphIndex leftgi, GlyphIndex rightgi) const
+PairProgram::find_kern(GlyphIndex leftgi, GlyphIndex rightgi) const
 {
+  if (_frozen) {
+    const GlyphIndex *r = _csr_right.begin();
+    const GlyphIndex *end = r + _csr_first[leftgi + 1];
+    for (const GlyphIndex *x = std::lower_bound(r + _csr_first[leftgi], end, rightgi);
+         x != end && *x == rightgi; x++)
+      if (op(_csr_op[x - r]).is_kern())
+        return _csr_op[x - r];
+    return -1;
+  }
+
   PairOpIndex opi = find_left(leftgi);
   while (opi >= 0) {
-    if (op(opi).right() == rightgi)
+    if (op(opi).right() == rightgi && op(opi).is_kern())
       return opi;
     opi = op(opi).next_left();
   }
@@ -56,6 +69,7 @@ PairProgram::add_kern(GlyphIndex left, GlyphIndex right, int ki)
   int newopi = _op.size();
   _op.push_back(newop);
   _left_map[left] = newopi;
+  _frozen = false;
 
   //PairOpIndex duplicate = map[newop];
   //map.add(newop, newopi);
@@ -72,6 +86,7 @@ PairProgram::add_lig(GlyphIndex left, GlyphIndex right, GlyphIndex result,
   int newopi = _op.size();
   _op.push_back(newop);
   _left_map[left] = newopi;
+  _frozen = false;
 
   //PairOpIndex duplicate = map[newop];
   //map.add(newop, newopi);
@@ -95,6 +110,54 @@ PairProgram::unreverse()
   }
 
   _reversed = false;
+  _frozen = false;
+}
+
+
+namespace {
+struct PairSortKey {
+  GlyphIndex right;
+  PairOpIndex opi;
+  int rank;
+  bool operator<(const PairSortKey &o) const {
+    return right < o.right || (right == o.right && rank < o.rank);
+  }
+};
+}
+
+void
+PairProgram::freeze()
+{
+  if (_frozen) return;
+
+  int nglyphs = _left_map.size();
+  _csr_first.assign(nglyphs + 1, 0);
+  for (PairOpIndex opi = 0; opi < _op.size(); opi++)
+    _csr_first[_op[opi].left() + 1]++;
+  for (int gi = 0; gi < nglyphs; gi++)
+    _csr_first[gi + 1] += _csr_first[gi];
+
+  // Duplicate pairs keep their order in the left_map chain, so find_kern()
+  // returns the same op whether or not the program is frozen.
+  Vector<PairSortKey> keys(_op.size(), PairSortKey());
+  for (int gi = 0; gi < nglyphs; gi++) {
+    int k = _csr_first[gi];
+    for (PairOpIndex opi = _left_map[gi]; opi >= 0; opi = _op[opi].next_left(), k++) {
+      keys[k].right = _op[opi].right();
+      keys[k].opi = opi;
+      keys[k].rank = k;
+    }
+  }
+
+  _csr_right.resize(_op.size());
+  _csr_op.resize(_op.size());
+  for (int gi = 0; gi < nglyphs; gi++) {
+    std::sort(keys.begin() + _csr_first[gi], keys.begin() + _csr_first[gi + 1]);
+    for (int i = _csr_first[gi]; i < _csr_first[gi + 1]; i++)
+      _csr_right[i] = keys[i].right, _csr_op[i] = keys[i].opi;
+  }
+
+  _frozen = true;
 }
 
 
@@ -18,6 +18,7 @@
 #endif
 #include <efont/psres.hh>
 #include <lcdf/slurper.hh>
+#include <lcdf/cachefile.hh>
 /* Get the correct functions for directory searching */
 #if HAVE_DIRENT_H
 # include <dirent.h>
@@ -237,6 +238,7 @@ PsresDatabase::add_one_psres_file(Slurper &slurper, bool override)
 bool
 PsresDatabase::add_psres_file(Filename &filename, bool override)
 {
+  _source_files.push_back(filename.path());
   Slurper slurpy(filename);
   return add_one_psres_file(slurpy, override);
 }
@@ -317,18 +319,138 @@ PsresDatabase::add_psres_path(const char *path, const char *default_path,
     while (*epath && *epath != ':') epath++;
 
     PermString directory(path, epath - path);
-    Filename filename(directory, "PSres.upr");
     if (epath == path) {
       add_psres_path(default_path, 0, false);
       default_path = 0; // don't use default path twice
-    } else if (!filename.readable() || !add_psres_file(filename, false))
-      add_psres_directory(directory);
+    } else
+      add_psres_path_directory(directory);
 
     path = (*epath ? epath+1 : epath);
   }
 }
 
 
+void
+PsresDatabase::add_psres_path_directory(PermString directory)
+{
+  // Read the directory's PSres.upr; unless that is exclusive, also read its
+  // other .upr files. The result is cached in a binary index, so later runs
+  // can skip parsing.
+  String cache = cache_filename(directory);
+  PsresDatabase db;
+  if (!cache || !db.read_cache(cache, directory)) {
+    Filename filename(directory, "PSres.upr");
+    if (!filename.readable() || !db.add_psres_file(filename, false))
+      db.add_psres_directory(directory);
+    if (cache)
+      db.write_cache(cache, directory);
+  }
+  add_database(&db, false);
+}
+
+
+/* Index cache. Each directory in a PSRESOURCEPATH gets one file in
+   $XDG_CACHE_HOME/lcdf-typetools (default ~/.cache/lcdf-typetools):
+
+     "PSRIDX01" directory size mtime
+     nfiles { path size mtime }
+     nsections { name nentries { key directory value escaped } }
+
+   The encoding is described in <lcdf/cachefile.hh>. The index is valid
+   while the directory and every file read have the recorded sizes and
+   modification times. Setting LCDF_TYPETOOLS_NOCACHE disables the cache. */
+
+static const char psres_cache_magic[] = "PSRIDX01";
+
+String
+PsresDatabase::cache_filename(PermString directory)
+{
+  return ::cache_filename("psres-", String(directory));
+}
+
+bool
+PsresDatabase::read_cache(const String &cache, PermString directory)
+{
+  CacheReader r;
+  if (!r.read(cache))
+    return false;
+
+  String str;
+  uint32_t nfiles = 0, nsections = 0, nentries = 0, escaped = 0;
+  if (!r.get(str) || str != psres_cache_magic
+      || !r.get(str) || str != String(directory)
+      || !r.check_file_stamp(directory)
+      || !r.get(nfiles))
+    return false;
+  for (uint32_t i = 0; i < nfiles; i++)
+    if (!r.get(str) || !r.check_file_stamp(str))
+      return false;
+
+  if (!r.get(nsections))
+    return false;
+  for (uint32_t i = 0; i < nsections; i++) {
+    if (!r.get(str) || !r.get(nentries))
+      return false;
+    PsresDatabaseSection *section = force_section(str);
+    for (uint32_t j = 0; j < nentries; j++) {
+      String key, dir, value;
+      if (!r.get(key) || !r.get(dir) || !r.get(value) || !r.get(escaped))
+        return false;
+      section->add_value(key, dir ? PermString(dir) : PermString(),
+                         value, escaped != 0);
+    }
+  }
+  return r.done();
+}
+
+void
+PsresDatabase::write_cache(const String &cache, PermString directory) const
+{
+  CacheWriter w;
+  w.put(String(psres_cache_magic));
+  w.put(String(directory));
+  if (!w.put_file_stamp(directory))
+    return;
+  w.put(_source_files.size());
+  for (int i = 0; i < _source_files.size(); i++) {
+    w.put(_source_files[i]);
+    if (!w.put_file_stamp(_source_files[i]))
+      return;
+  }
+
+  w.put(_sections.size() - 1);
+  for (int i = 1; i < _sections.size(); i++)
+    _sections[i]->write_cache(w);
+  w.write(cache, true);
+}
+
+void
+PsresDatabaseSection::write_cache(CacheWriter &w) const
+{
+  w.put(String(_section_name));
+  w.put(_values.size() - 1);
+  for (HashMap<PermString, int>::const_iterator i = _map.begin(); i; i++) {
+    int index = i.value();
+    w.put(String(i.key()));
+    w.put(String(_directories[index]));
+    w.put(_values[index]);
+    w.put(_value_escaped[index] ? 1 : 0);
+  }
+}
+
+void
+PsresDatabaseSection::add_value(PermString key, PermString directory,
+                                const String &value, bool escaped)
+{
+  if (_map[key] <= 0) {
+    _map.insert(key, _directories.size());
+    _directories.push_back(directory);
+    _values.push_back(value);
+    _value_escaped.push_back(escaped);
+  }
+}
+
+
 void
 PsresDatabase::add_database(PsresDatabase *db, bool override)
 {
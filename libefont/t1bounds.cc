@@ -17,6 +17,7 @@
 # include <config.h>
 #endif
 #include <efont/t1bounds.hh>
+#include <lcdf/straccum.hh>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -52,13 +53,10 @@ CharstringBounds::clear()
 void
 CharstringBounds::xf_mark(const Bezier &b)
 {
-    Bezier b1, b2;
-    b.halve(b1, b2);
-    xf_mark(b1.point(3));
-    if (!xf_controls_inside(b1))
-        xf_mark(b1);
-    if (!xf_controls_inside(b2))
-        xf_mark(b2);
+    double t[4];
+    int n = b.extrema(t);
+    for (int i = 0; i < n; ++i)
+        xf_mark(b.eval(t[i]));
 }
 
 void
@@ -162,4 +160,65 @@ CharstringBounds::bounds(const CharstringContext &g,
     return b.output(bb, width, true);
 }
 
+bool
+CharstringBounds::bounds(const Transform& transform, const CharstringProgram* program,
+                         int gid, double bb[4], double& width)
+{
+    CharstringBoundsCache* cache = program->bounds_cache();
+    const Vector<double>* weight_vec = program->mm_vector(CharstringProgram::VEC_WEIGHT, false);
+    Vector<double> no_weights;
+    if (!weight_vec)
+        weight_vec = &no_weights;
+
+    bool ok;
+    if (!cache->find(transform, gid, *weight_vec, bb, width, ok)) {
+        ok = bounds(transform, program->glyph_context(gid), bb, width);
+        cache->insert(transform, gid, *weight_vec, bb, width, ok);
+    }
+    return ok;
+}
+
+
+String
+CharstringBoundsCache::key(const Transform& xf, int gid, const Vector<double>& weight_vec)
+{
+    StringAccum sa;
+    sa.append(reinterpret_cast<const char*>(&gid), sizeof(gid));
+    for (int i = 0; i < 6; ++i) {
+        double d = xf[i];
+        sa.append(reinterpret_cast<const char*>(&d), sizeof(d));
+    }
+    if (weight_vec.size())
+        sa.append(reinterpret_cast<const char*>(weight_vec.begin()), sizeof(double) * weight_vec.size());
+    return sa.take_string();
+}
+
+bool
+CharstringBoundsCache::find(const Transform& xf, int gid, const Vector<double>& weight_vec,
+                            double bb[4], double& width, bool& ok) const
+{
+    int i = _map[key(xf, gid, weight_vec)];
+    if (i < 0)
+        return false;
+    const double* v = _values.begin() + 6 * i;
+    bb[0] = v[0];
+    bb[1] = v[1];
+    bb[2] = v[2];
+    bb[3] = v[3];
+    width = v[4];
+    ok = v[5] != 0;
+    return true;
+}
+
+void
+CharstringBoundsCache::insert(const Transform& xf, int gid, const Vector<double>& weight_vec,
+                              const double bb[4], double width, bool ok)
+{
+    _map.insert(key(xf, gid, weight_vec), _values.size() / 6);
+    for (int i = 0; i < 4; ++i)
+        _values.push_back(bb[i]);
+    _values.push_back(width);
+    _values.push_back(ok);
+}
+
 } // namespace Efont
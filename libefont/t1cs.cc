@@ -18,6 +18,8 @@
 #endif
 #include <efont/t1cs.hh>
 #include <efont/t1interp.hh>
+#include <efont/t1bounds.hh>
+#include <lcdf/straccum.hh>
 #include <string.h>
 namespace Efont {
 
@@ -128,6 +130,7 @@ Type1Charstring::prepend(const Type1Charstring &t1cs)
     if (t1cs._key >= 0)
         t1cs.decrypt();
     _s = t1cs._s + _s;
+    clear_decoded();
 }
 
 void
@@ -145,12 +148,9 @@ Type1Charstring::decrypt() const
     }
 }
 
-bool
-Type1Charstring::process(CharstringInterp &interp) const
+static bool
+type1_process_bytes(CharstringInterp &interp, const uint8_t *data, int left)
 {
-    const uint8_t *data = Type1Charstring::data();
-    int left = _s.length();
-
     while (left > 0) {
         bool more;
         int ahead;
@@ -160,12 +160,12 @@ Type1Charstring::process(CharstringInterp &interp) const
             ahead = 1;
 
         } else if (*data < 32) {                        // a command
-            if (*data == cEscape) {
+            if (*data == Charstring::cEscape) {
                 if (left < 2)
                     goto runoff_error;
-                more = interp.type1_command(cEscapeDelta + data[1]);
+                more = interp.type1_command(Charstring::cEscapeDelta + data[1]);
                 ahead = 2;
-            } else if (*data == cShortint) { // short integer
+            } else if (*data == Charstring::cShortint) { // short integer
                 if (left < 3)
                     goto runoff_error;
                 int16_t val = (data[1] << 8) | data[2];
@@ -210,6 +210,90 @@ Type1Charstring::process(CharstringInterp &interp) const
     return false;
 }
 
+static inline void
+append_instruction(StringAccum &sa, int op, int32_t value, int pos)
+{
+    char *x = sa.extend(sizeof(Charstring::Instruction));
+    if (x) {
+        Charstring::Instruction in;
+        in.value = value;
+        in.op = op;
+        in.pos = pos;
+        memcpy(x, &in, sizeof(in));
+    }
+}
+
+void
+Type1Charstring::decode() const
+{
+    // Decode complete items only; process() hands anything after
+    // _decoded_length back to type1_process_bytes, which reports runoff.
+    const uint8_t *data = Type1Charstring::data();
+    int len = _s.length(), pos = 0;
+    StringAccum sa;
+    if (len > 0xFFFF)
+        len = 0;
+    while (pos < len) {
+        int c = data[pos];
+        if (c >= 32 && c <= 246) {
+            append_instruction(sa, iInteger, c - 139, pos);
+            pos += 1;
+        } else if (c == cEscape) {
+            if (pos + 2 > len)
+                break;
+            append_instruction(sa, cEscapeDelta + data[pos + 1], 0, pos);
+            pos += 2;
+        } else if (c == cShortint) {
+            if (pos + 3 > len)
+                break;
+            append_instruction(sa, iInteger, (int16_t) ((data[pos + 1] << 8) | data[pos + 2]), pos);
+            pos += 3;
+        } else if (c < 32) {
+            append_instruction(sa, c, 0, pos);
+            pos += 1;
+        } else if (c <= 250) {
+            if (pos + 2 > len)
+                break;
+            append_instruction(sa, iInteger, ((c - 247) << 8) + 108 + data[pos + 1], pos);
+            pos += 2;
+        } else if (c <= 254) {
+            if (pos + 2 > len)
+                break;
+            append_instruction(sa, iInteger, -((c - 251) << 8) - 108 - data[pos + 1], pos);
+            pos += 2;
+        } else {
+            if (pos + 5 > len)
+                break;
+            append_instruction(sa, iInteger, ((uint32_t) data[pos + 1] << 24) | (data[pos + 2] << 16) | (data[pos + 3] << 8) | data[pos + 4], pos);
+            pos += 5;
+        }
+    }
+    _decoded = sa.take_string();
+    _decoded_length = pos;
+}
+
+bool
+Type1Charstring::process(CharstringInterp &interp) const
+{
+    if (_decoded_length < 0)
+        decode();
+
+    const char *x = _decoded.data(), *end = x + _decoded.length();
+    for (; x != end; x += sizeof(Instruction)) {
+        Instruction in;
+        memcpy(&in, x, sizeof(in));
+        bool more;
+        if (in.op == iInteger)
+            more = interp.number(in.value);
+        else
+            more = interp.type1_command(in.op);
+        if (!more)
+            return interp.error() == CharstringInterp::errOK;
+    }
+
+    return type1_process_bytes(interp, data() + _decoded_length, _s.length() - _decoded_length);
+}
+
 int
 Type1Charstring::first_caret_after(int pos) const
 {
@@ -244,24 +328,25 @@ Type1Charstring::assign_substring(int pos, int len, const String &cs)
     if (pos < 0 || len < 0 || pos + len >= _s.length())
         /* do nothing */;
     else if (cs.length() == len) {
+        clear_decoded();
         char *d = _s.mutable_data();
         memcpy(d + pos, cs.data(), cs.length());
     } else if (cs.length() <= len) {
+        clear_decoded();
         char *d = _s.mutable_data();
         memcpy(d + pos, cs.data(), cs.length());
         memmove(d + pos + cs.length(), d + pos + len, _s.length() - pos - len);
         _s = _s.substring(0, cs.length() - len);
-    } else
+    } else {
+        clear_decoded();
         _s = _s.substring(0, pos) + cs + _s.substring(pos + len);
+    }
 }
 
 
-bool
-Type2Charstring::process(CharstringInterp &interp) const
+static bool
+type2_process_bytes(CharstringInterp &interp, const uint8_t *data, int left)
 {
-    const uint8_t *data = Type2Charstring::data();
-    int left = _s.length();
-
     while (left > 0) {
         bool more;
         int ahead;
@@ -271,18 +356,18 @@ Type2Charstring::process(CharstringInterp &interp) const
             ahead = 1;
 
         } else if (*data < 32) {                        // a command
-            if (*data == cEscape) {
+            if (*data == Charstring::cEscape) {
                 if (left < 2)
                     goto runoff_error;
-                more = interp.type2_command(cEscapeDelta + data[1], 0, 0);
+                more = interp.type2_command(Charstring::cEscapeDelta + data[1], 0, 0);
                 ahead = 2;
-            } else if (*data == cShortint) { // short integer
+            } else if (*data == Charstring::cShortint) { // short integer
                 if (left < 3)
                     goto runoff_error;
                 int16_t val = (data[1] << 8) | data[2];
                 more = interp.number(val);
                 ahead = 3;
-            } else if (*data == cHintmask || *data == cCntrmask) {
+            } else if (*data == Charstring::cHintmask || *data == Charstring::cCntrmask) {
                 int left_ptr = left - 1;
                 more = interp.type2_command(data[0], data + 1, &left_ptr);
                 ahead = 1 + (left - 1) - left_ptr;
@@ -325,10 +410,135 @@ Type2Charstring::process(CharstringInterp &interp) const
     return false;
 }
 
+void
+Type2Charstring::decode() const
+{
+    // Hintmask length depends on the number of stems, which subroutines
+    // can change; guess from this charstring's own stem commands.
+    // process() checks the guess and falls back to bytes if it's wrong.
+    const uint8_t *data = Type2Charstring::data();
+    int len = _s.length(), pos = 0, last_pos = 0, nargs = 0, nstems = 0;
+    StringAccum sa;
+    if (len > 0xFFFF)
+        len = 0;
+    while (pos < len) {
+        int c = data[pos];
+        last_pos = pos;
+        if (c >= 32 && c <= 246) {
+            append_instruction(sa, iInteger, c - 139, pos);
+            pos += 1;
+            nargs++;
+            continue;
+        } else if (c == cShortint) {
+            if (pos + 3 > len)
+                break;
+            append_instruction(sa, iInteger, (int16_t) ((data[pos + 1] << 8) | data[pos + 2]), pos);
+            pos += 3;
+            nargs++;
+            continue;
+        } else if (c >= 247 && c <= 250) {
+            if (pos + 2 > len)
+                break;
+            append_instruction(sa, iInteger, ((c - 247) << 8) + 108 + data[pos + 1], pos);
+            pos += 2;
+            nargs++;
+            continue;
+        } else if (c >= 251 && c <= 254) {
+            if (pos + 2 > len)
+                break;
+            append_instruction(sa, iInteger, -((c - 251) << 8) - 108 - data[pos + 1], pos);
+            pos += 2;
+            nargs++;
+            continue;
+        } else if (c == 255) {
+            if (pos + 5 > len)
+                break;
+            append_instruction(sa, iFixed, (data[pos + 1] << 24) | (data[pos + 2] << 16) | (data[pos + 3] << 8) | data[pos + 4], pos);
+            pos += 5;
+            nargs++;
+            continue;
+        } else if (c == cEscape) {
+            if (pos + 2 > len)
+                break;
+            append_instruction(sa, cEscapeDelta + data[pos + 1], 0, pos);
+            pos += 2;
+        } else if (c == cHintmask || c == cCntrmask) {
+            nstems += nargs / 2;
+            append_instruction(sa, c, 0, pos);
+            pos += 1 + ((nstems + 7) >> 3);
+        } else {
+            if (c == cHstem || c == cVstem || c == cHstemhm || c == cVstemhm)
+                nstems += nargs / 2;
+            append_instruction(sa, c, 0, pos);
+            pos += 1;
+        }
+        nargs = 0;
+    }
+    if (pos > len) {            // truncated hintmask: leave it to bytes
+        sa.pop_back(sizeof(Instruction));
+        pos = last_pos;
+    }
+    _decoded = sa.take_string();
+    _decoded_length = pos;
+}
+
+bool
+Type2Charstring::process(CharstringInterp &interp) const
+{
+    if (_decoded_length < 0)
+        decode();
+
+    const uint8_t *data = Type2Charstring::data();
+    int len = _s.length();
+    const char *x = _decoded.data(), *end = x + _decoded.length();
+    int next_pos = _decoded_length;
+    for (; x != end; x += sizeof(Instruction)) {
+        Instruction in;
+        memcpy(&in, x, sizeof(in));
+        bool more;
+        if (in.op == iInteger)
+            more = interp.number(in.value);
+        else if (in.op == iFixed)
+            more = interp.number(in.value / 65536.);
+        else if (in.op == cHintmask || in.op == cCntrmask) {
+            int left_ptr = len - in.pos - 1;
+            more = interp.type2_command(in.op, data + in.pos + 1, &left_ptr);
+            int pos = len - left_ptr;
+            Instruction next;
+            if (x + sizeof(Instruction) != end)
+                memcpy(&next, x + sizeof(Instruction), sizeof(next));
+            else
+                next.pos = _decoded_length;
+            if (more && pos != next.pos) {
+                next_pos = pos;
+                break;
+            }
+        } else
+            more = interp.type2_command(in.op, 0, 0);
+        if (!more)
+            return interp.error() == CharstringInterp::errOK;
+    }
+
+    return type2_process_bytes(interp, data + next_pos, len - next_pos);
+}
+
 
 CharstringProgram::CharstringProgram(unsigned units_per_em)
     : _parent_program(false),
-      _units_per_em(units_per_em ? units_per_em : 1000) {
+      _units_per_em(units_per_em ? units_per_em : 1000), _bounds_cache(0) {
+}
+
+CharstringProgram::~CharstringProgram()
+{
+    delete _bounds_cache;
+}
+
+CharstringBoundsCache *
+CharstringProgram::bounds_cache() const
+{
+    if (!_bounds_cache)
+        _bounds_cache = new CharstringBoundsCache;
+    return _bounds_cache;
 }
 
 const CharstringProgram *
@@ -353,6 +563,24 @@ CharstringProgram::glyph_names(Vector<PermString> &gnames) const
         gnames[i] = glyph_name(i);
 }
 
+void
+CharstringProgram::glyph_metrics(Vector<double>& widths, Vector<double>& lsbs,
+                                 Vector<double>& bboxes) const
+{
+    // interpret every glyph; results are kept in the bounds cache
+    int n = nglyphs();
+    widths.resize(n);
+    lsbs.resize(n);
+    bboxes.resize(4 * n);
+    Transform identity;
+    for (int gi = 0; gi < n; gi++) {
+        double* bb = bboxes.begin() + 4 * gi;
+        if (!CharstringBounds::bounds(identity, this, gi, bb, widths[gi]))
+            widths[gi] = UNKDOUBLE;
+        lsbs[gi] = bb[0];
+    }
+}
+
 Vector<double> *
 CharstringProgram::mm_vector(VectorType, bool) const
 {
@@ -403,6 +403,54 @@ Type1PFBReader::preserve_whitespace() const
 }
 
 
+/*****
+ * Type1StringReader
+ **/
+
+Type1StringReader::Type1StringReader(const String &str)
+    : _str(str), _pos(0), _binary(false), _left(0)
+{
+    _pfb = (_str.length() > 0 && (unsigned char) _str[0] == 128);
+}
+
+int
+Type1StringReader::more_data(unsigned char *data, int len)
+{
+    const unsigned char *s = _str.udata();
+    int slen = _str.length();
+
+    if (!_pfb)
+        _left = slen - _pos;
+    while (_left == 0) {
+        if (_pos + 6 > slen || s[_pos] != 128
+            || s[_pos + 1] < 1 || s[_pos + 1] > 2)
+            return -1;
+        _binary = (s[_pos + 1] == 2);
+        _left = s[_pos + 2] | (s[_pos + 3] << 8) | (s[_pos + 4] << 16)
+            | (s[_pos + 5] << 24);
+        _pos += 6;
+    }
+
+    if (_left < 0 || _pos >= slen)
+        return -1;
+
+    if (len > _left)
+        len = _left;
+    if (len > slen - _pos)
+        len = slen - _pos;
+    memcpy(data, s + _pos, len);
+    _pos += len;
+    _left -= len;
+    return len;
+}
+
+bool
+Type1StringReader::preserve_whitespace() const
+{
+    return _binary;
+}
+
+
 /*****
  * Type1SubsetReader
  **/
@@ -514,7 +562,7 @@ Type1Writer &
 Type1Writer::operator<<(double x)
 {
     char str[256];
-    size_t len = snprintf(str, sizeof(str), "%g", x);
+    int len = StringAccum::format_double(str, sizeof(str), x, 6);
     print(str, len);
     return *this;
 }
@@ -560,14 +608,21 @@ void
 Type1PFAWriter::print0(const unsigned char *c, int l)
 {
     if (eexecing()) {
+        // encode into a local buffer; 78 hex digits per line
         const char *hex = "0123456789ABCDEF";
-        for (; l; c++, l--) {
-            putc(hex[*c / 16], _f);
-            putc(hex[*c % 16], _f);
-            if (++_hex_line == 39) {
-                putc('\n', _f);
-                _hex_line = 0;
+        char buf[2048];
+        while (l) {
+            char *x = buf;
+            for (; l && x <= buf + sizeof(buf) - 3; c++, l--) {
+                *x++ = hex[*c / 16];
+                *x++ = hex[*c % 16];
+                if (++_hex_line == 39) {
+                    *x++ = '\n';
+                    _hex_line = 0;
+                }
             }
+            ssize_t result = fwrite(buf, 1, x - buf, _f);
+            (void) result;
         }
     } else {
         ssize_t result = fwrite(c, 1, l, _f);
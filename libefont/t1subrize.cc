@@ -0,0 +1,449 @@
+// -*- related-file-name: "../include/efont/t1subrize.hh" -*-
+
+/* t1subrize.{cc,hh} -- factor repeated charstring code into subroutines
+ *
+ * Copyright (c) 2026 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <efont/t1subrize.hh>
+#include <efont/t1item.hh>
+#include <efont/t1csgen.hh>
+#include <lcdf/straccum.hh>
+#include <lcdf/hashmap.hh>
+#include <algorithm>
+namespace Efont {
+
+static inline int
+type1_number_length(int n)
+{
+    if (n >= -107 && n <= 107)
+        return 1;
+    else if (n >= -1131 && n <= 1131)
+        return 2;
+    else
+        return 5;
+}
+
+static bool
+type1_movable_command(int cmd)
+{
+    switch (cmd) {
+      case Charstring::cHstem:
+      case Charstring::cVstem:
+      case Charstring::cVmoveto:
+      case Charstring::cRlineto:
+      case Charstring::cHlineto:
+      case Charstring::cVlineto:
+      case Charstring::cRrcurveto:
+      case Charstring::cClosepath:
+      case Charstring::cRmoveto:
+      case Charstring::cHmoveto:
+      case Charstring::cVhcurveto:
+      case Charstring::cHvcurveto:
+      case Charstring::cDotsection:
+      case Charstring::cVstem3:
+      case Charstring::cHstem3:
+        return true;
+      default:
+        return false;
+    }
+}
+
+
+CharstringSubroutinizer::CharstringSubroutinizer(int nglyphs)
+    : _glyph_offsets(nglyphs, Vector<int>()),
+      _charstrings(nglyphs, String()), _max_subrs(max_subrs_limit),
+      _bytes_saved(0)
+{
+}
+
+void
+CharstringSubroutinizer::build_sequence()
+{
+    // Movable commands are interned, so equal commands get equal symbols;
+    // every other command, and the separator after each glyph, gets a
+    // unique symbol that no repeat can span.
+    HashMap<String, int> symbols(-1);
+    int nglyphs = _glyph_offsets.size();
+    int nunique = 0;
+
+    _seq.clear();
+    _seq_glyph.clear();
+    _seq_offset.clear();
+    _seq_bytes.assign(1, 0);
+    _glyph_start.clear();
+
+    for (int g = 0; g < nglyphs; ++g) {
+        const Vector<int> &offsets = _glyph_offsets[g];
+        const char *data = _charstrings[g].data();
+        _glyph_start.push_back(_seq.size());
+        for (int i = 0; i + 1 < offsets.size(); ++i) {
+            int off = offsets[i] >> 1, next = offsets[i + 1] >> 1;
+            int sym;
+            if (offsets[i] & 1) {
+                int &symp = symbols.find_force(String(data + off, next - off));
+                if (symp < 0)
+                    symp = symbols.size() - 1;
+                sym = symp;
+            } else
+                sym = -1 - nunique++;
+            _seq.push_back(sym);
+            _seq_glyph.push_back(g);
+            _seq_offset.push_back(off);
+            _seq_bytes.push_back(_seq_bytes.back() + next - off);
+        }
+        _seq.push_back(-1 - nunique++);
+        _seq_glyph.push_back(g);
+        _seq_offset.push_back(offsets.size() ? offsets.back() >> 1 : 0);
+        _seq_bytes.push_back(_seq_bytes.back());
+    }
+    _glyph_start.push_back(_seq.size());
+
+    // renumber unique symbols to follow the interned ones
+    int nsymbols = symbols.size();
+    for (int i = 0; i < _seq.size(); ++i)
+        if (_seq[i] < 0)
+            _seq[i] = nsymbols - 1 - _seq[i];
+}
+
+namespace {
+struct SuffixCmp {
+    const int *rank;
+    int n;
+    int k;
+    SuffixCmp(const int *rank_, int n_, int k_)
+        : rank(rank_), n(n_), k(k_) {
+    }
+    bool operator()(int a, int b) const {
+        if (rank[a] != rank[b])
+            return rank[a] < rank[b];
+        int ra = (a + k < n ? rank[a + k] : -1);
+        int rb = (b + k < n ? rank[b + k] : -1);
+        return ra < rb;
+    }
+};
+}
+
+void
+CharstringSubroutinizer::suffix_array(Vector<int> &sa) const
+{
+    // prefix doubling; unique separators keep the number of rounds near
+    // log2 of the longest repeat
+    int n = _seq.size();
+    Vector<int> rank(_seq), tmp(n, 0);
+    sa.resize(n);
+    for (int i = 0; i < n; ++i)
+        sa[i] = i;
+    for (int k = 1; n > 0; k <<= 1) {
+        SuffixCmp cmp(rank.begin(), n, k);
+        std::sort(sa.begin(), sa.end(), cmp);
+        tmp[sa[0]] = 0;
+        for (int i = 1; i < n; ++i)
+            tmp[sa[i]] = tmp[sa[i - 1]] + (cmp(sa[i - 1], sa[i]) ? 1 : 0);
+        rank.swap(tmp);
+        if (rank[sa[n - 1]] == n - 1)
+            break;
+    }
+}
+
+void
+CharstringSubroutinizer::lcp_array(const Vector<int> &sa, Vector<int> &lcp) const
+{
+    // Kasai et al.; lcp[i] is the common prefix of sa[i-1] and sa[i]
+    int n = sa.size();
+    Vector<int> rank(n, 0);
+    lcp.assign(n, 0);
+    for (int i = 0; i < n; ++i)
+        rank[sa[i]] = i;
+    for (int i = 0, h = 0; i < n; ++i)
+        if (rank[i] > 0) {
+            int j = sa[rank[i] - 1];
+            while (i + h < n && j + h < n && _seq[i + h] == _seq[j + h])
+                ++h;
+            lcp[rank[i]] = h;
+            if (h > 0)
+                --h;
+        } else
+            h = 0;
+}
+
+void
+CharstringSubroutinizer::find_candidates(const Vector<int> &sa, const Vector<int> &lcp, Vector<Candidate> &candidates) const
+{
+    // Each lcp-interval [lb, rb] with value len is a command sequence that
+    // occurs rb - lb + 1 times. Estimate its savings as if every occurrence
+    // could be replaced by a call to the first new subroutine.
+    int overhead = subr_overhead();
+    Vector<Candidate> stack;
+    Candidate c;
+    c.lb = 0;
+    c.len = 0;
+    stack.push_back(c);
+    int n = sa.size();
+    for (int i = 1; i <= n; ++i) {
+        int l = (i < n ? lcp[i] : 0);
+        int lb = i - 1;
+        while (l < stack.back().len) {
+            c = stack.back();
+            stack.pop_back();
+            c.rb = i - 1;
+            int bytes = command_bytes(sa[c.lb], c.len);
+            c.savings = (c.rb - c.lb + 1) * (bytes - call_bytes(0)) - (bytes + 1 + overhead);
+            if (c.savings > 0)
+                candidates.push_back(c);
+            lb = c.lb;
+        }
+        if (l > stack.back().len) {
+            c.lb = lb;
+            c.len = l;
+            stack.push_back(c);
+        }
+    }
+}
+
+bool
+CharstringSubroutinizer::candidate_cmp(const Candidate &a, const Candidate &b)
+{
+    if (a.savings != b.savings)
+        return a.savings > b.savings;
+    return a.lb < b.lb;
+}
+
+int
+CharstringSubroutinizer::choose_subrs()
+{
+    build_sequence();
+    _new_subrs.clear();
+    _bytes_saved = 0;
+    if (_max_subrs <= 0)
+        return 0;
+
+    Vector<int> sa, lcp;
+    Vector<Candidate> candidates;
+    suffix_array(sa);
+    lcp_array(sa, lcp);
+    find_candidates(sa, lcp, candidates);
+    std::sort(candidates.begin(), candidates.end(), candidate_cmp);
+
+    // Greedily take candidates, keeping occurrences that do not overlap an
+    // earlier choice. _replacement[p] is the new subr starting at p, -1 for
+    // untouched commands, and -2 for commands inside a replacement.
+    int overhead = subr_overhead();
+    _replacement.assign(_seq.size(), -1);
+    Vector<int> occurrences;
+    for (Candidate *c = candidates.begin();
+         c != candidates.end() && _new_subrs.size() < _max_subrs;
+         ++c) {
+        occurrences.clear();
+        for (int i = c->lb; i <= c->rb; ++i)
+            occurrences.push_back(sa[i]);
+        std::sort(occurrences.begin(), occurrences.end());
+
+        int nocc = 0, last_end = 0;
+        for (int *p = occurrences.begin(); p != occurrences.end(); ++p) {
+            if (*p < last_end)
+                continue;
+            int j = 0;
+            while (j < c->len && _replacement[*p + j] == -1)
+                ++j;
+            if (j == c->len) {
+                occurrences[nocc++] = *p;
+                last_end = *p + c->len;
+            }
+        }
+        if (nocc < 2)
+            continue;
+
+        int bytes = command_bytes(occurrences[0], c->len);
+        int savings = nocc * (bytes - call_bytes(_new_subrs.size()))
+            - (bytes + 1 + overhead);
+        if (savings <= 0)
+            continue;
+
+        NewSubr ns;
+        ns.pos = occurrences[0];
+        ns.len = c->len;
+        ns.ncalls = nocc;
+        for (int i = 0; i < nocc; ++i) {
+            int p = occurrences[i];
+            _replacement[p] = _new_subrs.size();
+            for (int j = 1; j < c->len; ++j)
+                _replacement[p + j] = -2;
+        }
+        _new_subrs.push_back(ns);
+        _bytes_saved += savings;
+    }
+
+    return _new_subrs.size();
+}
+
+String
+CharstringSubroutinizer::subr_body(int i) const
+{
+    const NewSubr &ns = _new_subrs[i];
+    return _charstrings[_seq_glyph[ns.pos]].substring(_seq_offset[ns.pos], command_bytes(ns.pos, ns.len));
+}
+
+void
+CharstringSubroutinizer::subr_callers(Vector<Vector<int> > &callers) const
+{
+    callers.assign(_new_subrs.size(), Vector<int>());
+    for (int p = 0; p < _replacement.size(); ++p)
+        if (_replacement[p] >= 0) {
+            Vector<int> &glyphs = callers[_replacement[p]];
+            if (!glyphs.size() || glyphs.back() != _seq_glyph[p])
+                glyphs.push_back(_seq_glyph[p]);
+        }
+}
+
+void
+CharstringSubroutinizer::set_subr_call(int i, const String &call)
+{
+    _new_subrs[i].call = call;
+}
+
+void
+CharstringSubroutinizer::rewrite(int first_glyph, int last_glyph)
+{
+    if (!_new_subrs.size())
+        return;
+    StringAccum sa;
+    for (int g = first_glyph; g < last_glyph; ++g) {
+        int p = _glyph_start[g], end = _glyph_start[g + 1] - 1;
+        int q = p;
+        while (q < end && _replacement[q] == -1)
+            ++q;
+        if (q == end)
+            continue;
+
+        const char *data = _charstrings[g].data();
+        while (p < end) {
+            if (_replacement[p] >= 0) {
+                const NewSubr &ns = _new_subrs[_replacement[p]];
+                sa << ns.call;
+                p += ns.len;
+            } else {
+                sa.append(data + _seq_offset[p], command_bytes(p, 1));
+                ++p;
+            }
+        }
+        _charstrings[g] = sa.take_string();
+    }
+}
+
+
+/*****
+ * Type1Subroutinizer
+ **/
+
+Type1Subroutinizer::Type1Subroutinizer(Type1Font *font)
+    : CharstringSubroutinizer(font->nglyphs()), _font(font),
+      _first_subrno(font->nsubrs())
+{
+    // A font without Subrs has nowhere to put new ones.
+    set_max_subrs(_first_subrno ? max_subrs_limit - _first_subrno : 0);
+    for (int g = 0; g < nglyphs(); ++g)
+        set_charstring(g, font->glyph(g)->data_string());
+}
+
+int
+Type1Subroutinizer::call_bytes(int i) const
+{
+    return type1_number_length(_first_subrno + i) + 1;
+}
+
+int
+Type1Subroutinizer::subr_overhead() const
+{
+    // "dup N LEN RD <...> NP", plus four bytes of charstring encryption
+    return 20;
+}
+
+void
+Type1Subroutinizer::tokenize(int first_glyph, int last_glyph)
+{
+    // "div" only computes an operand, so it doesn't end a command.
+    for (int g = first_glyph; g < last_glyph; ++g) {
+        Vector<int> &offsets = _glyph_offsets[g];
+        offsets.clear();
+        const uint8_t *data = charstring(g).udata();
+        int len = charstring(g).length();
+
+        int pos = 0, start = 0;
+        while (pos < len) {
+            int c = data[pos];
+            if (c >= 32) {
+                pos += (c <= 246 ? 1 : (c <= 254 ? 2 : 5));
+                continue;
+            } else if (c == Charstring::cShortint) {
+                pos += 3;
+                continue;
+            }
+            int cmd = c;
+            if (c == Charstring::cEscape) {
+                cmd = Charstring::cEscapeDelta + (pos + 1 < len ? data[pos + 1] : 0);
+                pos += 2;
+            } else
+                pos++;
+            if (cmd == Charstring::cDiv)
+                continue;
+            if (pos > len)
+                pos = len;
+            offsets.push_back((start << 1) | type1_movable_command(cmd));
+            start = pos;
+        }
+        if (start < len)
+            offsets.push_back(start << 1);
+        offsets.push_back(len << 1);
+    }
+}
+
+namespace {
+struct SubrCallsCmp {
+    const CharstringSubroutinizer &subrizer;
+    SubrCallsCmp(const CharstringSubroutinizer &subrizer_)
+        : subrizer(subrizer_) {
+    }
+    bool operator()(int a, int b) const {
+        int ca = subrizer.subr_ncalls(a), cb = subrizer.subr_ncalls(b);
+        return ca > cb || (ca == cb && a < b);
+    }
+};
+}
+
+int
+Type1Subroutinizer::run()
+{
+    tokenize(0, nglyphs());
+    if (!choose_subrs())
+        return 0;
+
+    // Give the most-called subroutines the shortest numbers.
+    Vector<int> order;
+    for (int i = 0; i < nsubrs_added(); ++i)
+        order.push_back(i);
+    std::sort(order.begin(), order.end(), SubrCallsCmp(*this));
+    for (int i = 0; i < order.size(); ++i) {
+        int subrno = _first_subrno + i;
+        _font->set_subr(subrno, Type1Charstring(subr_body(order[i]) + "\013"));
+        set_subr_call(order[i], Type1CharstringGen::callsubr_string(subrno));
+    }
+
+    rewrite(0, nglyphs());
+    for (int g = 0; g < nglyphs(); ++g)
+        _font->glyph_x(g)->t1cs().assign(charstring(g));
+    return nsubrs_added();
+}
+
+}
@@ -28,7 +28,7 @@ typedef OpenType::Glyph Glyph;
 
 TrueTypeBoundsCharstringProgram::TrueTypeBoundsCharstringProgram(const OpenType::Font* otf)
     : CharstringProgram(otf->units_per_em()),
-      _otf(otf), _nglyphs(-1), _loca_long(false),
+      _otf(otf), _nglyphs(-1), _nhmtx(0), _loca_long(false),
       _loca(otf->table("loca")), _glyf(otf->table("glyf")),
       _hmtx(otf->table("hmtx")), _got_glyph_names(false), _got_unicodes(false)
 {
@@ -158,6 +158,82 @@ TrueTypeBoundsCharstringProgram::glyph_names(Vector<PermString> &gn) const
         gn.push_back(glyph_name(gi));
 }
 
+bool
+TrueTypeBoundsCharstringProgram::glyph_location(int gi, uint32_t& offset,
+                                                uint32_t& end_offset) const
+{
+    if (_loca_long) {
+        offset = _loca.u32(gi * 4);
+        end_offset = _loca.u32(gi * 4 + 4);
+    } else {
+        offset = _loca.u16(gi * 2) * 2;
+        end_offset = _loca.u16(gi * 2 + 2) * 2;
+    }
+    return offset == end_offset
+        || (offset < end_offset && offset + 10 <= end_offset
+            && end_offset <= (uint32_t) _glyf.length());
+}
+
+bool
+TrueTypeBoundsCharstringProgram::glyph_header(int gi, int& ncontours,
+                                              int bbox[4], int& advance_width,
+                                              int& lsb) const
+{
+    // calculate glyf offsets
+    uint32_t offset, end_offset;
+    if (!glyph_location(gi, offset, end_offset))
+        return false;
+
+    // fetch bounding box from glyf
+    if (offset != end_offset) {
+        ncontours = _glyf.s16(offset);
+        bbox[0] = _glyf.s16(offset + 2);
+        bbox[1] = _glyf.s16(offset + 4);
+        bbox[2] = _glyf.s16(offset + 6);
+        bbox[3] = _glyf.s16(offset + 8);
+    } else
+        ncontours = bbox[0] = bbox[1] = bbox[2] = bbox[3] = 0;
+
+    // fetch horizontal metrics
+    if (gi >= _nhmtx) {
+        advance_width = (_nhmtx ? _hmtx.u16((_nhmtx - 1) * 4) : 0);
+        int hmtx_offset = _nhmtx * 4 + (gi - _nhmtx) * 2;
+        lsb = (hmtx_offset + 2 <= _hmtx.length() ? _hmtx.s16(hmtx_offset) : 0);
+    } else {
+        advance_width = _hmtx.u16(gi * 4);
+        lsb = _hmtx.s16(gi * 4 + 2);
+    }
+    return true;
+}
+
+void
+TrueTypeBoundsCharstringProgram::glyph_metrics(Vector<double>& widths,
+                                               Vector<double>& lsbs,
+                                               Vector<double>& bboxes) const
+{
+    // read hmtx and glyf headers directly; no charstrings needed
+    int n = (_nglyphs > 0 ? _nglyphs : 0);
+    widths.resize(n);
+    lsbs.resize(n);
+    bboxes.resize(4 * n);
+    for (int gi = 0; gi < n; gi++) {
+        int ncontours, bbox[4], advance_width, lsb;
+        double* bb = bboxes.begin() + 4 * gi;
+        if (!glyph_header(gi, ncontours, bbox, advance_width, lsb)) {
+            widths[gi] = UNKDOUBLE;
+            lsbs[gi] = bb[0] = bb[1] = bb[2] = bb[3] = 0;
+        } else if (ncontours == 0) {
+            widths[gi] = advance_width;
+            lsbs[gi] = bb[0] = bb[1] = bb[2] = bb[3] = 0;
+        } else {
+            widths[gi] = advance_width;
+            lsbs[gi] = lsb;
+            for (int i = 0; i < 4; i++)
+                bb[i] = bbox[i];
+        }
+    }
+}
+
 Charstring *
 TrueTypeBoundsCharstringProgram::glyph(int gi) const
 {
@@ -166,41 +242,10 @@ TrueTypeBoundsCharstringProgram::glyph(int gi) const
     if (_charstrings.size() <= gi)
         _charstrings.resize(gi + 1, (Charstring *) 0);
     if (!_charstrings[gi]) {
-        // calculate glyf offsets
-        uint32_t offset, end_offset;
-        if (_loca_long) {
-            offset = _loca.u32(gi * 4);
-            end_offset = _loca.u32(gi * 4 + 4);
-        } else {
-            offset = _loca.u16(gi * 2) * 2;
-            end_offset = _loca.u16(gi * 2 + 2) * 2;
-        }
-
-        // fetch bounding box from glyf
-        int ncontours, xmin, ymin, xmax, ymax;
-        if (offset != end_offset) {
-            if (offset > end_offset || offset + 10 > end_offset
-                || end_offset > (uint32_t) _glyf.length())
-                return 0;
-
-            ncontours = _glyf.s16(offset);
-            xmin = _glyf.s16(offset + 2);
-            ymin = _glyf.s16(offset + 4);
-            xmax = _glyf.s16(offset + 6);
-            ymax = _glyf.s16(offset + 8);
-        } else
-            ncontours = xmin = ymin = xmax = ymax = 0;
-
-        // fetch horizontal metrics
-        int advance_width, lsb;
-        if (gi >= _nhmtx) {
-            advance_width = (_nhmtx ? _hmtx.u16((_nhmtx - 1) * 4) : 0);
-            int hmtx_offset = _nhmtx * 4 + (gi - _nhmtx) * 2;
-            lsb = (hmtx_offset + 2 <= _hmtx.length() ? _hmtx.s16(hmtx_offset) : 0);
-        } else {
-            advance_width = _hmtx.u16(gi * 4);
-            lsb = _hmtx.s16(gi * 4 + 2);
-        }
+        int ncontours, bbox[4], advance_width, lsb;
+        if (!glyph_header(gi, ncontours, bbox, advance_width, lsb))
+            return 0;
+        int xmin = bbox[0], ymin = bbox[1], xmax = bbox[2], ymax = bbox[3];
 
         // make charstring
         Type1CharstringGen gen;
@@ -229,4 +274,275 @@ TrueTypeBoundsCharstringProgram::glyph(int gi) const
     return _charstrings[gi];
 }
 
+
+
+/*****
+ * TrueTypeCharstringProgram
+ **/
+
+// Glyph flags
+enum {
+    F_ON_CURVE = 0x01, F_X_SHORT = 0x02, F_Y_SHORT = 0x04, F_REPEAT = 0x08,
+    F_X_SAME = 0x10, F_Y_SAME = 0x20
+};
+
+// Component flags
+enum {
+    C_ARG_WORDS = 0x0001, C_ARGS_XY = 0x0002, C_SCALE = 0x0008,
+    C_MORE = 0x0020, C_XY_SCALE = 0x0040, C_2X2 = 0x0080,
+    C_SCALED_OFFSET = 0x0800
+};
+
+static const int max_composite_depth = 16;
+
+TrueTypeCharstringProgram::TrueTypeCharstringProgram(const OpenType::Font* otf)
+    : TrueTypeBoundsCharstringProgram(otf)
+{
+}
+
+bool
+TrueTypeCharstringProgram::read_simple(uint32_t offset, uint32_t end_offset,
+                                       Outline& o) const
+{
+    int ncontours = _glyf.s16(offset);
+    int first = o.points.size();
+    uint32_t pos = offset + 10;
+    int npoints = 0;
+    for (int c = 0; c < ncontours; c++, pos += 2) {
+        int end = _glyf.u16(pos) + 1;
+        if (end < npoints)
+            return false;
+        npoints = end;
+        o.contour_ends.push_back(first + end - 1);
+    }
+    pos += 2 + _glyf.u16(pos);  // skip instructions
+
+    // flags
+    Vector<uint8_t> flags;
+    flags.reserve(npoints);
+    while (flags.size() < npoints) {
+        uint8_t f = _glyf[pos++];
+        int n = 1;
+        if (f & F_REPEAT)
+            n += _glyf[pos++];
+        while (n-- > 0 && flags.size() < npoints)
+            flags.push_back(f);
+    }
+
+    // coordinates are deltas; x values come first
+    o.points.resize(first + npoints, Point(0, 0));
+    Point* pts = o.points.begin() + first;
+    for (int xy = 0; xy < 2; xy++) {
+        uint8_t short_flag = (xy ? F_Y_SHORT : F_X_SHORT);
+        uint8_t same_flag = (xy ? F_Y_SAME : F_X_SAME);
+        int v = 0;
+        for (int i = 0; i < npoints; i++) {
+            if (flags[i] & short_flag) {
+                int d = _glyf[pos++];
+                v += (flags[i] & same_flag ? d : -d);
+            } else if (!(flags[i] & same_flag)) {
+                v += _glyf.s16(pos);
+                pos += 2;
+            }
+            (xy ? pts[i].y : pts[i].x) = v;
+        }
+    }
+    if (pos > end_offset)
+        return false;
+
+    for (int i = 0; i < npoints; i++)
+        o.on_curve.push_back((flags[i] & F_ON_CURVE) != 0);
+    return true;
+}
+
+static inline double
+f2dot14(int16_t x)
+{
+    return x / 16384.;
+}
+
+bool
+TrueTypeCharstringProgram::read_composite(uint32_t offset, uint32_t end_offset,
+                                          Outline& o, int depth) const
+{
+    uint32_t pos = offset + 10;
+    int flags;
+    do {
+        flags = _glyf.u16(pos);
+        int gi = _glyf.u16(pos + 2);
+        pos += 4;
+
+        int arg1, arg2;
+        if (flags & C_ARG_WORDS) {
+            arg1 = (flags & C_ARGS_XY ? _glyf.s16(pos) : _glyf.u16(pos));
+            arg2 = (flags & C_ARGS_XY ? _glyf.s16(pos + 2) : _glyf.u16(pos + 2));
+            pos += 4;
+        } else {
+            arg1 = (flags & C_ARGS_XY ? (int8_t) _glyf[pos] : _glyf[pos]);
+            arg2 = (flags & C_ARGS_XY ? (int8_t) _glyf[pos + 1] : _glyf[pos + 1]);
+            pos += 2;
+        }
+
+        // x' = a*x + c*y, y' = b*x + d*y
+        double a = 1, b = 0, c = 0, d = 1;
+        if (flags & C_SCALE) {
+            a = d = f2dot14(_glyf.s16(pos));
+            pos += 2;
+        } else if (flags & C_XY_SCALE) {
+            a = f2dot14(_glyf.s16(pos));
+            d = f2dot14(_glyf.s16(pos + 2));
+            pos += 4;
+        } else if (flags & C_2X2) {
+            a = f2dot14(_glyf.s16(pos));
+            b = f2dot14(_glyf.s16(pos + 2));
+            c = f2dot14(_glyf.s16(pos + 4));
+            d = f2dot14(_glyf.s16(pos + 6));
+            pos += 8;
+        }
+        if (pos > end_offset)
+            return false;
+
+        Outline co;
+        if (!read_outline(gi, co, depth + 1))
+            return false;
+        for (Point* p = co.points.begin(); p != co.points.end(); ++p)
+            *p = Point(a * p->x + c * p->y, b * p->x + d * p->y);
+
+        Point delta;
+        if (flags & C_ARGS_XY) {
+            delta = Point(arg1, arg2);
+            if (flags & C_SCALED_OFFSET)
+                delta = Point(a * arg1 + c * arg2, b * arg1 + d * arg2);
+        } else if (arg1 < o.points.size() && arg2 < co.points.size())
+            // align point arg2 of the component with point arg1 so far
+            delta = o.points[arg1] - co.points[arg2];
+        else
+            return false;
+
+        int first = o.points.size();
+        for (int i = 0; i < co.points.size(); i++) {
+            o.points.push_back(co.points[i] + delta);
+            o.on_curve.push_back(co.on_curve[i]);
+        }
+        for (int i = 0; i < co.contour_ends.size(); i++)
+            o.contour_ends.push_back(first + co.contour_ends[i]);
+    } while (flags & C_MORE);
+    return true;
+}
+
+bool
+TrueTypeCharstringProgram::read_outline(int gi, Outline& o, int depth) const
+{
+    uint32_t offset, end_offset;
+    if (gi < 0 || gi >= _nglyphs || depth > max_composite_depth
+        || !glyph_location(gi, offset, end_offset))
+        return false;
+    if (offset == end_offset)
+        return true;
+    else if (_glyf.s16(offset) >= 0)
+        return read_simple(offset, end_offset, o);
+    else
+        return read_composite(offset, end_offset, o, depth);
+}
+
+static void
+gen_point(Type1CharstringGen& gen, const Point& p)
+{
+    const Point& cur = gen.current_point(true);
+    gen.gen_number(p.x - cur.x, 'x');
+    gen.gen_number(p.y - cur.y, 'y');
+}
+
+static void
+gen_quadratic(Type1CharstringGen& gen, const Point& control, const Point& p)
+{
+    // exact degree elevation to a cubic
+    Point p0 = gen.current_point(true);
+    gen_point(gen, p0 + (control - p0) * (2. / 3));
+    gen_point(gen, p + (control - p) * (2. / 3));
+    gen_point(gen, p);
+    gen.gen_command(Charstring::cRrcurveto);
+}
+
+Charstring *
+TrueTypeCharstringProgram::glyph(int gi) const
+{
+    if (gi < 0 || gi >= _nglyphs)
+        return 0;
+    if (_charstrings.size() <= gi)
+        _charstrings.resize(gi + 1, (Charstring *) 0);
+    if (_charstrings[gi])
+        return _charstrings[gi];
+
+    int ncontours, bbox[4], advance_width, lsb;
+    Outline o;
+    try {
+        if (!glyph_header(gi, ncontours, bbox, advance_width, lsb)
+            || !read_outline(gi, o, 0))
+            return 0;
+    } catch (OpenType::Bounds) {
+        return 0;
+    }
+
+    Type1CharstringGen gen(64);
+    gen.gen_number(o.contour_ends.size() ? lsb : 0, 'X');
+    gen.gen_number(advance_width);
+    gen.gen_command(Charstring::cHsbw);
+
+    for (int c = 0, first = 0; c < o.contour_ends.size(); first = o.contour_ends[c] + 1, c++) {
+        int last = o.contour_ends[c];
+        // single-point contours are hinting anchors and draw nothing
+        if (last - first < 1)
+            continue;
+        const Point* pts = o.points.begin();
+        const bool* on = o.on_curve.begin();
+
+        // start at an on-curve point, or between two off-curve points
+        Point start;
+        int i = first, end = last;
+        if (on[first])
+            start = pts[first], i = first + 1, end = last + 1;
+        else if (on[last])
+            start = pts[last], end = last;
+        else
+            start = (pts[first] + pts[last]) * 0.5, end = last + 1;
+        gen.gen_moveto(start, false, true);
+
+        bool have_control = false;
+        Point control;
+        for (; i < end; i++)
+            if (on[i]) {
+                if (have_control)
+                    gen_quadratic(gen, control, pts[i]);
+                else {
+                    gen_point(gen, pts[i]);
+                    gen.gen_command(Charstring::cRlineto);
+                }
+                have_control = false;
+            } else {
+                if (have_control)
+                    gen_quadratic(gen, control, (control + pts[i]) * 0.5);
+                control = pts[i];
+                have_control = true;
+            }
+        // closepath supplies any final line
+        if (have_control)
+            gen_quadratic(gen, control, start);
+        gen.gen_command(Charstring::cClosepath);
+    }
+    gen.gen_command(Charstring::cEndchar);
+
+    _charstrings[gi] = gen.output();
+    return _charstrings[gi];
+}
+
+void
+TrueTypeCharstringProgram::glyph_metrics(Vector<double>& widths,
+                                         Vector<double>& lsbs,
+                                         Vector<double>& bboxes) const
+{
+    // measure the outlines glyph() returns, not the glyf header boxes
+    CharstringProgram::glyph_metrics(widths, lsbs, bboxes);
+}
+
 }
@@ -17,6 +17,7 @@
 # include <config.h>
 #endif
 #include <lcdf/bezier.hh>
+#include <math.h>
 
 //
 // bounding box
@@ -77,6 +78,49 @@ Bezier::eval(double u) const noexcept
 }
 
 
+//
+// extrema
+//
+
+static int
+quadratic_roots(double a, double b, double c, double *t)
+{
+    // roots of a*t^2 + b*t + c in the open interval (0, 1)
+    int n = 0;
+    if (fabs(a) <= 1e-12 * (fabs(b) + fabs(c))) {
+        if (b != 0)
+            t[n++] = -c / b;
+    } else {
+        double disc = b * b - 4 * a * c;
+        if (disc < 0)
+            return 0;
+        double q = -0.5 * (b + (b < 0 ? -sqrt(disc) : sqrt(disc)));
+        t[n++] = q / a;
+        if (q != 0)
+            t[n++] = c / q;
+    }
+    int k = 0;
+    for (int i = 0; i < n; ++i)
+        if (t[i] > 0 && t[i] < 1)
+            t[k++] = t[i];
+    return k;
+}
+
+int
+Bezier::extrema(double t[4]) const noexcept
+{
+    // The derivative of each coordinate is a quadratic; its roots are the
+    // parameters where the curve turns horizontally or vertically.
+    int n = quadratic_roots(-_p[0].x + 3 * (_p[1].x - _p[2].x) + _p[3].x,
+                            2 * (_p[0].x - 2 * _p[1].x + _p[2].x),
+                            _p[1].x - _p[0].x, t);
+    n += quadratic_roots(-_p[0].y + 3 * (_p[1].y - _p[2].y) + _p[3].y,
+                         2 * (_p[0].y - 2 * _p[1].y + _p[2].y),
+                         _p[1].y - _p[0].y, t + n);
+    return n;
+}
+
+
 //
 // halve
 //
@@ -0,0 +1,182 @@
+// -*- related-file-name: "../include/lcdf/cachefile.hh" -*-
+
+/* cachefile.{cc,hh} -- binary cache and index files
+ *
+ * Copyright (c) 2026 Eddie Kohler
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version. This program is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include <lcdf/cachefile.hh>
+#include <lcdf/error.hh>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+# include <unistd.h>
+#endif
+
+void
+CacheWriter::put(uint32_t x)
+{
+    unsigned char *c = (unsigned char *) _sa.extend(4);
+    c[0] = x; c[1] = x >> 8; c[2] = x >> 16; c[3] = x >> 24;
+}
+
+bool
+CacheWriter::put_file_stamp(const String &filename)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) < 0)
+        return false;
+    put64(st.st_size);
+    put64(st.st_mtime);
+    return true;
+}
+
+bool
+CacheWriter::write(const String &filename, bool create_directories, ErrorHandler *errh) const
+{
+    LocalErrorHandler lerrh(errh);
+#ifndef WIN32
+    // create the cache directory and its parent if necessary
+    if (create_directories) {
+        String dir = filename.substring(0, filename.find_right('/'));
+        if (mkdir(dir.c_str(), 0777) < 0 && errno == ENOENT) {
+            mkdir(dir.substring(0, dir.find_right('/')).c_str(), 0777);
+            mkdir(dir.c_str(), 0777);
+        }
+    }
+#else
+    (void) create_directories;
+#endif
+
+    // write atomically, so readers never see a partial file
+    StringAccum tmp;
+    tmp << filename << '.';
+#ifndef WIN32
+    tmp << getpid();
+#else
+    tmp << "tmp";
+#endif
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        lerrh.error("%s: %s", tmp.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = fwrite(_sa.data(), 1, _sa.length(), f) == (size_t) _sa.length();
+    if (fclose(f) != 0)
+        ok = false;
+#ifdef WIN32
+    remove(filename.c_str());
+#endif
+    if (ok && rename(tmp.c_str(), filename.c_str()) == 0)
+        return true;
+    lerrh.error("%s: %s", filename.c_str(), strerror(errno));
+    remove(tmp.c_str());
+    return false;
+}
+
+bool
+CacheReader::read(const String &filename, ErrorHandler *errh)
+{
+    LocalErrorHandler lerrh(errh);
+    _data = read_whole_file(filename, &lerrh);
+    _s = _data.udata();
+    _end = _s + _data.length();
+    return lerrh.nerrors() == 0;
+}
+
+bool
+CacheReader::get(uint32_t &x)
+{
+    if (_end - _s < 4)
+        return false;
+    x = _s[0] | (_s[1] << 8) | (_s[2] << 16) | ((uint32_t) _s[3] << 24);
+    _s += 4;
+    return true;
+}
+
+bool
+CacheReader::get(String &str)
+{
+    uint32_t len;
+    if (!get(len) || (uint32_t) (_end - _s) < len)
+        return false;
+    str = String((const char *) _s, len);
+    _s += len;
+    return true;
+}
+
+bool
+CacheReader::check_file_stamp(const String &filename)
+{
+    struct stat st;
+    unsigned long long size, mtime;
+    return get64(size) && get64(mtime)
+        && stat(filename.c_str(), &st) == 0
+        && size == (unsigned long long) st.st_size
+        && mtime == (unsigned long long) st.st_mtime;
+}
+
+String
+read_whole_file(const String &filename, ErrorHandler *errh)
+{
+    LocalErrorHandler lerrh(errh);
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (!f) {
+        lerrh.error("%s: %s", filename.c_str(), strerror(errno));
+        return String();
+    }
+    StringAccum sa;
+    while (!feof(f) && !ferror(f)) {
+        char *x = sa.reserve(32768);
+        if (!x)
+            break;
+        sa.adjust_length(fread(x, 1, 32768, f));
+    }
+    if (ferror(f))
+        lerrh.error("%s: %s", filename.c_str(), strerror(errno));
+    fclose(f);
+    return sa.take_string();
+}
+
+String
+cache_filename(const char *prefix, const String &key)
+{
+#ifndef WIN32
+    const char *nocache = getenv("LCDF_TYPETOOLS_NOCACHE");
+    if (nocache && *nocache)
+        return String();
+    StringAccum sa;
+    if (const char *xdg = getenv("XDG_CACHE_HOME"))
+        sa << xdg;
+    else if (const char *home = getenv("HOME"))
+        sa << home << "/.cache";
+    else
+        return String();
+    sa << "/lcdf-typetools/" << prefix;
+
+    // name the cache after a hash of the key
+    uint32_t hash = 2166136261U;
+    for (const char *x = key.begin(); x != key.end(); x++)
+        hash = (hash ^ (unsigned char) *x) * 16777619U;
+    sa.snprintf(9, "%08x", hash);
+    return sa.take_string();
+#else
+    (void) prefix, (void) key;
+    return String();
+#endif
+}
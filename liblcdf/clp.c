@@ -182,12 +182,30 @@ typedef struct {
 } Clp_Oclass;
 #define Clp_OclassSize          10
 
+typedef struct {
+    const char *name;           /* long name without "no-" prefix */
+    int optno;
+} Clp_LongIndex;
+
+#define Clp_ShortIndexSize      256
+
+typedef struct Clp_ResponseFile {
+    struct Clp_ResponseFile *next;
+    char *text;
+    const char **argv;
+} Clp_ResponseFile;
+#define Clp_MaxResponseFiles    256
+
 typedef struct Clp_Internal {
     const Clp_Option *opt;
     Clp_InternOption *iopt;
     int nopt;
     unsigned opt_generation;
 
+    Clp_LongIndex *long_index;
+    int nlong_index;
+    int short_index[Clp_ShortIndexSize];
+
     Clp_ValType *valtype;
     int nvaltype;
 
@@ -209,6 +227,10 @@ typedef struct Clp_Internal {
     int option_processing;
     int current_option;
 
+    int response_files;
+    int nresponse_files;
+    Clp_ResponseFile *response_file_list;
+
     unsigned char is_short;
     unsigned char whole_negated; /* true if negated by an option character */
     unsigned char could_be_short;
@@ -466,6 +488,45 @@ calculate_lmm(Clp_Parser *clp, const Clp_Option *opt, Clp_InternOption *iopt, in
     }
 }
 
+static int
+long_index_compare(const void *a, const void *b)
+{
+    const Clp_LongIndex *la = (const Clp_LongIndex *) a;
+    const Clp_LongIndex *lb = (const Clp_LongIndex *) b;
+    int cmp = strcmp(la->name, lb->name);
+    return cmp ? cmp : la->optno - lb->optno;
+}
+
+static void
+build_option_index(Clp_Internal *cli)
+     /* Sorts the long names, so find_prefix_opt can binary search for the
+        options an argument might abbreviate, and records the first option
+        with each short name. If memory runs out, find_prefix_opt falls
+        back to a linear search. */
+{
+    int i;
+    free(cli->long_index);
+    cli->long_index = (Clp_LongIndex *)malloc(sizeof(Clp_LongIndex) * (cli->nopt ? cli->nopt : 1));
+    cli->nlong_index = 0;
+    if (cli->long_index) {
+        for (i = 0; i < cli->nopt; ++i)
+            if (cli->iopt[i].ilong) {
+                Clp_LongIndex *li = &cli->long_index[cli->nlong_index];
+                li->name = cli->opt[i].long_name + cli->iopt[i].ilongoff;
+                li->optno = i;
+                ++cli->nlong_index;
+            }
+        qsort(cli->long_index, cli->nlong_index, sizeof(Clp_LongIndex),
+              long_index_compare);
+    }
+
+    for (i = 0; i < Clp_ShortIndexSize; ++i)
+        cli->short_index[i] = cli->nopt;
+    for (i = cli->nopt - 1; i >= 0; --i)
+        if (cli->iopt[i].ishort && cli->opt[i].short_name < Clp_ShortIndexSize)
+            cli->short_index[cli->opt[i].short_name] = i;
+}
+
 /** @param argc number of arguments
  * @param argv argument array
  * @param nopt number of option definitions
@@ -508,8 +569,14 @@ Clp_NewParser(int argc, const char * const *argv, int nopt, const Clp_Option *op
     Clp_Parser *clp = (Clp_Parser *)malloc(sizeof(Clp_Parser));
     Clp_Internal *cli = (Clp_Internal *)malloc(sizeof(Clp_Internal));
     Clp_InternOption *iopt = (Clp_InternOption *)malloc(sizeof(Clp_InternOption) * nopt);
-    if (cli)
+    if (cli) {
         cli->valtype = (Clp_ValType *)malloc(sizeof(Clp_ValType) * Clp_InitialValType);
+        cli->long_index = 0;
+        cli->nlong_index = 0;
+        cli->response_files = 0;
+        cli->nresponse_files = 0;
+        cli->response_file_list = 0;
+    }
     if (!clp || !cli || !iopt || !cli->valtype)
         goto failed;
 
@@ -597,8 +664,17 @@ Clp_DeleteParser(Clp_Parser *clp)
             free(clsl);
         }
 
+    while (cli->response_file_list) {
+        Clp_ResponseFile *rf = cli->response_file_list;
+        cli->response_file_list = rf->next;
+        free(rf->text);
+        free(rf->argv);
+        free(rf);
+    }
+
     free(cli->valtype);
     free(cli->iopt);
+    free(cli->long_index);
     free(cli);
     free(clp);
 }
@@ -850,6 +926,7 @@ Clp_SetOptions(Clp_Parser *clp, int nopt, const Clp_Option *opt)
 
     /* Check option set */
     calculate_lmm(clp, opt, iopt, nopt);
+    build_option_index(cli);
 
     return 0;
 }
@@ -904,6 +981,29 @@ Clp_SetOptionProcessing(Clp_Parser *clp, int on)
 }
 
 
+/** @param clp the parser
+ * @param on whether to expand response files
+ * @return previous response file setting
+ *
+ * When response files are on, an argument of the form <tt>@@FILE</tt> is
+ * replaced by the arguments in FILE, which are separated by whitespace.
+ * Single and double quotes group characters into one argument, and a
+ * backslash outside single quotes escapes the next character.  Response
+ * files may name other response files.  If FILE cannot be read, the argument
+ * is left as it is.  Arguments after <tt>"--"</tt>, and the values of
+ * options that require one, are never expanded.  By default response files
+ * are off.
+ */
+int
+Clp_SetResponseFiles(Clp_Parser *clp, int on)
+{
+    Clp_Internal *cli = clp->internal;
+    int old = cli->response_files;
+    cli->response_files = on;
+    return old;
+}
+
+
 /*******
  * functions for Clp_Option lists
  **/
@@ -948,6 +1048,66 @@ argcmp(const char *ref, const char *arg, int min_match, int fewer_dashes)
         return arg - argstart;
 }
 
+static int
+prefix_opt_match(Clp_Parser *clp, const char *arg, const Clp_Option *o,
+                 const Clp_InternOption *io, int fewer_dashes, int negated,
+                 int first_charlen)
+     /* Returns argcmp() of 'arg' against option 'o', or 0 if 'o' can't
+        match in this context. */
+{
+    int lmm;
+    if (!io->ilong || (negated ? !io->ineg : !io->ipos))
+        return 0;
+    lmm = (negated ? io->lmmneg : io->lmmpos);
+    if (clp && clp->internal->could_be_short
+        && (negated ? io->lmmneg_short : io->lmmpos_short))
+        lmm = (first_charlen >= lmm ? first_charlen + 1 : lmm);
+    return argcmp(o->long_name + io->ilongoff, arg, lmm, fewer_dashes);
+}
+
+static int
+long_index_lower_bound(const Clp_LongIndex *index, int nindex,
+                       const char *key, int keylen)
+     /* Returns the first index entry whose name is not less than the
+        'keylen'-byte prefix 'key'. Entries whose names start with that
+        prefix follow it. */
+{
+    int l = 0, r = nindex;
+    while (l < r) {
+        int m = l + (r - l) / 2;
+        if (strncmp(index[m].name, key, keylen) < 0)
+            l = m + 1;
+        else
+            r = m;
+    }
+    return l;
+}
+
+static int
+find_indexed_prefix_opt(Clp_Parser *clp, const char *arg,
+                        const Clp_Option *opt, const Clp_InternOption *iopt,
+                        const char *key, int keylen, int fewer_dashes,
+                        int negated, int first_charlen, int *ambiguous)
+     /* Checks the options whose long names start with 'key'. Returns the
+        lowest-numbered match, as a linear search would. Sets *ambiguous
+        if some option matched too few characters. */
+{
+    Clp_Internal *cli = clp->internal;
+    int i, best = -1;
+    for (i = long_index_lower_bound(cli->long_index, cli->nlong_index, key, keylen);
+         i < cli->nlong_index && strncmp(cli->long_index[i].name, key, keylen) == 0;
+         ++i) {
+        int optno = cli->long_index[i].optno;
+        int len = prefix_opt_match(clp, arg, &opt[optno], &iopt[optno],
+                                   fewer_dashes, negated, first_charlen);
+        if (len > 0 && (best < 0 || optno < best))
+            best = optno;
+        else if (len < 0)
+            *ambiguous = 1;
+    }
+    return best;
+}
+
 static int
 find_prefix_opt(Clp_Parser *clp, const char *arg,
                 int nopt, const Clp_Option *opt,
@@ -961,18 +1121,42 @@ find_prefix_opt(Clp_Parser *clp, const char *arg,
     int i, fewer_dashes = 0, first_ambiguous = *ambiguous;
     int negated = clp && clp->negated;
     int first_charlen = (clp ? clp_utf8_charlen(clp->internal, arg) : 1);
+    int keylen = strcspn(arg, "=");
+    int indexed = clp && clp->internal->opt == opt
+        && clp->internal->long_index && keylen > 0;
 
   retry:
-    for (i = 0; i < nopt; i++) {
-        int len, lmm;
-        if (!iopt[i].ilong || (negated ? !iopt[i].ineg : !iopt[i].ipos))
-            continue;
+    /* Use the sorted index when possible. Without fewer_dashes, only
+       options starting with the whole argument can match; with it, only
+       options starting with its first character or a dash can. An
+       ambiguous result falls through to the linear search, which reports
+       possibilities in option order. */
+    if (indexed) {
+        int any_ambiguous = 0, optno;
+        if (!fewer_dashes)
+            optno = find_indexed_prefix_opt(clp, arg, opt, iopt, arg, keylen,
+                                            0, negated, first_charlen,
+                                            &any_ambiguous);
+        else {
+            int optno2;
+            optno = find_indexed_prefix_opt(clp, arg, opt, iopt, arg, 1,
+                                            1, negated, first_charlen,
+                                            &any_ambiguous);
+            optno2 = find_indexed_prefix_opt(clp, arg, opt, iopt, "-", 1,
+                                             1, negated, first_charlen,
+                                             &any_ambiguous);
+            if (optno2 >= 0 && (optno < 0 || optno2 < optno))
+                optno = optno2;
+        }
+        if (optno >= 0)
+            return optno;
+        else if (!any_ambiguous)
+            goto next;
+    }
 
-        lmm = (negated ? iopt[i].lmmneg : iopt[i].lmmpos);
-        if (clp && clp->internal->could_be_short
-            && (negated ? iopt[i].lmmneg_short : iopt[i].lmmpos_short))
-            lmm = (first_charlen >= lmm ? first_charlen + 1 : lmm);
-        len = argcmp(opt[i].long_name + iopt[i].ilongoff, arg, lmm, fewer_dashes);
+    for (i = 0; i < nopt; i++) {
+        int len = prefix_opt_match(clp, arg, &opt[i], &iopt[i],
+                                   fewer_dashes, negated, first_charlen);
         if (len > 0)
             return i;
         else if (len < 0) {
@@ -982,6 +1166,7 @@ find_prefix_opt(Clp_Parser *clp, const char *arg,
         }
     }
 
+  next:
     /* If there were no partial matches, try again with fewer_dashes true */
     if (*ambiguous == first_ambiguous && !fewer_dashes) {
         fewer_dashes = 1;
@@ -1569,6 +1754,107 @@ get_oclass(Clp_Parser *clp, const char *text, int *ocharskip)
     return Clp_OptionChar(clp, c);
 }
 
+static char *
+read_response_file(const char *filename, size_t *lenp)
+{
+    FILE *f = fopen(filename, "rb");
+    char *text = 0;
+    size_t len = 0, cap = 0;
+    if (!f)
+        return 0;
+    while (!feof(f) && !ferror(f)) {
+        if (cap - len < 4096) {
+            char *ntext = (char *)realloc(text, cap ? cap * 2 : 8192);
+            if (!ntext)
+                break;
+            text = ntext;
+            cap = (cap ? cap * 2 : 8192);
+        }
+        len += fread(text + len, 1, cap - len - 1, f);
+    }
+    if (ferror(f) || !text || cap - len < 1) {
+        free(text);
+        text = 0;
+    } else
+        *lenp = len;
+    fclose(f);
+    return text;
+}
+
+static int
+expand_response_file(Clp_Parser *clp)
+     /* Replaces the current argument, "@FILE", with the arguments in FILE.
+        Returns 1 on success, after which cli->argv[0] is a placeholder. */
+{
+    Clp_Internal *cli = clp->internal;
+    Clp_ResponseFile *rf;
+    const char **argv;
+    char *text, *s, *end, *out;
+    size_t len;
+    int nargs = 0, cap = 16, i;
+
+    if (cli->nresponse_files >= Clp_MaxResponseFiles) {
+        Clp_OptionError(clp, "too many response files");
+        return 0;
+    }
+    if (!(text = read_response_file(cli->argv[0] + 1, &len)))
+        return 0;
+    rf = (Clp_ResponseFile *)malloc(sizeof(Clp_ResponseFile));
+    argv = (const char **)malloc(sizeof(const char *) * (cap + cli->argc));
+    if (!rf || !argv)
+        goto failed;
+
+    /* split into arguments in place; output never overtakes input */
+    s = text;
+    end = text + len;
+    while (1) {
+        int quote = 0;
+        while (s != end && isspace((unsigned char) *s))
+            ++s;
+        if (s == end)
+            break;
+        if (nargs == cap) {
+            const char **nargv = (const char **)realloc(argv, sizeof(const char *) * (2 * cap + cli->argc));
+            if (!nargv)
+                goto failed;
+            argv = nargv;
+            cap *= 2;
+        }
+        argv[++nargs] = out = s;
+        for (; s != end && (quote || !isspace((unsigned char) *s)); ++s)
+            if (*s == quote)
+                quote = 0;
+            else if (!quote && (*s == '\'' || *s == '\"'))
+                quote = *s;
+            else if (*s == '\\' && quote != '\'' && s + 1 != end)
+                *out++ = *++s;
+            else
+                *out++ = *s;
+        if (s != end)
+            ++s;
+        *out = 0;
+    }
+
+    /* placeholder, file arguments, then the remaining arguments */
+    argv[0] = cli->argv[0];
+    for (i = 1; i < cli->argc; ++i)
+        argv[nargs + i] = cli->argv[i];
+    rf->text = text;
+    rf->argv = argv;
+    rf->next = cli->response_file_list;
+    cli->response_file_list = rf;
+    ++cli->nresponse_files;
+    cli->argv = argv;
+    cli->argc += nargs;
+    return 1;
+
+  failed:
+    free(text);
+    free(argv);
+    free(rf);
+    return 0;
+}
+
 static int
 next_argument(Clp_Parser *clp, int want_argument)
      /* Moves clp to the next argument.
@@ -1623,6 +1909,7 @@ next_argument(Clp_Parser *clp, int want_argument)
     cli->whole_negated = 0;
     cli->xtext = 0;
 
+  next_arg:
     if (cli->argc <= 1)
         return 0;
 
@@ -1630,6 +1917,10 @@ next_argument(Clp_Parser *clp, int want_argument)
     cli->argv++;
     text = cli->argv[0];
 
+    if (text[0] == '@' && text[1] && want_argument < 2
+        && cli->response_files && expand_response_file(clp))
+        goto next_arg;
+
     if (want_argument > 1)
         goto not_option;
 
@@ -1791,7 +2082,9 @@ find_short(Clp_Parser *clp, const char *text)
     else
         c = (unsigned char) *text;
 
-    for (i = 0; i < cli->nopt; i++)
+    /* no earlier option has this short name */
+    i = (c >= 0 && c < Clp_ShortIndexSize ? cli->short_index[c] : 0);
+    for (; i < cli->nopt; i++)
         if (iopt[i].ishort && opt[i].short_name == c
             && (!clp->negated || iopt[i].ineg)) {
             clp->negated = clp->negated || !iopt[i].ipos;
@@ -1183,3 +1183,160 @@ BailErrorHandler::account(int level)
 }
 
 #endif
+
+
+//
+// BUFFERED ERROR HANDLER
+//
+
+BufferedErrorHandler::BufferedErrorHandler(ErrorHandler *errh, bool aggregate)
+    : ErrorVeneer(errh), _record_map(-1), _aggregate(aggregate)
+{
+}
+
+BufferedErrorHandler::~BufferedErrorHandler()
+{
+    flush();
+}
+
+void *
+BufferedErrorHandler::emit(const String &str, void *, bool more)
+{
+    _pending += str;
+    if (more)
+        _pending += '\n';
+    return 0;
+}
+
+void
+BufferedErrorHandler::account(int level)
+{
+    String text = _pending;
+    _pending = String();
+
+    int *rp = (_aggregate && text ? _record_map.findp(text) : 0);
+    if (rp) {
+        ++_records[*rp].count;
+        if (level < _records[*rp].level)
+            _records[*rp].level = level;
+    } else {
+        if (_aggregate && text)
+            _record_map.insert(text, _records.size());
+        Record r;
+        r.text = text;
+        r.level = level;
+        r.count = 1;
+        _records.push_back(r);
+    }
+
+    // the base handler sees a fatal message, and exits, only after every
+    // earlier message
+    if (level <= el_fatal)
+        flush();
+    ErrorHandler::account(level);
+}
+
+void
+BufferedErrorHandler::flush()
+{
+    ErrorHandler *errh = _errh;
+    for (Record *r = _records.begin(); errh && r != _records.end(); ++r) {
+        String count_anno;
+        if (r->count > 1)
+            count_anno = make_anno("count", String(r->count));
+        const char *s = r->text.begin(), *end = r->text.end();
+        void *user_data = 0;
+        do {
+            const char *nl = std::find(s, end, '\n');
+            String line = r->text.substring(s, nl);
+            if (count_anno && s == r->text.begin())
+                line = combine_anno(line, count_anno);
+            s = nl + (nl != end);
+            user_data = errh->emit(line, user_data, s != end);
+        } while (s != end);
+        for (int i = 0; i < r->count; ++i)
+            errh->account(r->level);
+    }
+    _records.clear();
+    _record_map.clear();
+}
+
+
+#ifndef __KERNEL__
+//
+// JSON ERROR HANDLER
+//
+
+JsonErrorHandler::JsonErrorHandler(FILE *f, const String &program)
+    : _f(f), _program(program), _level(1000), _count(1)
+{
+}
+
+void *
+JsonErrorHandler::emit(const String &str, void *user_data, bool more)
+{
+    String landmark;
+    int level = 1000, count = 1;
+    const char *s = parse_anno(str, str.begin(), str.end(),
+                               "l", &landmark, "#<>", &level,
+                               "#count", &count, (const char *) 0);
+    if (!user_data) {
+        // the level member makes warning()'s text prefix redundant
+        if (level == el_warning && str.end() - s >= 9
+            && memcmp(s, "warning: ", 9) == 0)
+            s += 9;
+        _message = str.substring(s, str.end());
+        _landmark = landmark;
+        _level = level;
+        _count = count;
+    } else {
+        _message += '\n';
+        _message += str.substring(s, str.end());
+        if (!_landmark)
+            _landmark = landmark;
+        if (level < _level)
+            _level = level;
+    }
+    if (more)
+        return this;
+
+    const char *level_name;
+    if (_level <= el_fatal)
+        level_name = "fatal";
+    else if (_level <= el_error)
+        level_name = "error";
+    else if (_level == el_warning)
+        level_name = "warning";
+    else if (_level == el_notice)
+        level_name = "notice";
+    else if (_level == el_info)
+        level_name = "info";
+    else if (_level == el_debug)
+        level_name = "debug";
+    else
+        level_name = "message";
+
+    StringAccum sa;
+    sa << '{';
+    if (_program) {
+        sa << "\"program\":";
+        sa.append_json_string(_program);
+        sa << ',';
+    }
+    sa << "\"level\":\"" << level_name << '\"';
+    if (String l = clean_landmark(_landmark)) {
+        sa << ",\"landmark\":";
+        sa.append_json_string(l);
+    }
+    sa << ",\"message\":";
+    sa.append_json_string(_message);
+    if (_count > 1)
+        sa << ",\"count\":" << _count;
+    sa << "}\n";
+    ssize_t result = fwrite(sa.begin(), 1, sa.length(), _f);
+    (void) result;
+    _message = _landmark = String();
+    return 0;
+}
+
+#endif
@@ -86,9 +86,18 @@ char *
 Slurper::get_line_at(unsigned pos)
 {
   while (1) {
-    for (; pos < _len; pos++)
-      if (_data[pos] == '\n' || _data[pos] == '\r')
+    // memchr is much faster than a byte loop; look for `\r' only before
+    // the first `\n'
+    if (pos < _len) {
+      unsigned char *nl = (unsigned char *) memchr(_data + pos, '\n', _len - pos);
+      unsigned end = (nl ? nl - _data : _len);
+      unsigned char *cr = (unsigned char *) memchr(_data + pos, '\r', end - pos);
+      if (cr || nl) {
+        pos = (cr ? cr - _data : end);
         goto line_ends_at_pos;
+      }
+      pos = _len;
+    }
 
     // no line end? look for more data. save and reset `pos', since _pos
     // may change.
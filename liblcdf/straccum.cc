@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
+#include <math.h>
 
 /** @class StringAccum
  * @brief Efficiently build up Strings from pieces.
@@ -223,6 +224,20 @@ StringAccum::swap(StringAccum& o)
     _len = olen, _cap = ocap;
 }
 
+static int
+unparse_unsigned(char* x, unsigned long long u)
+{
+    char buf[24];
+    char* s = buf + sizeof(buf);
+    do {
+        *--s = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    int len = buf + sizeof(buf) - s;
+    memcpy(x, s, len);
+    return len;
+}
+
 /** @relates StringAccum
     @brief Append decimal representation of @a i to @a sa.
     @return @a sa */
@@ -230,7 +245,13 @@ StringAccum&
 operator<<(StringAccum& sa, long i)
 {
     if (char* x = sa.reserve(24)) {
-        int len = snprintf(x, 24, "%ld", i);
+        int len = 0;
+        unsigned long long u = i;
+        if (i < 0) {
+            x[len++] = '-';
+            u = -u;
+        }
+        len += unparse_unsigned(x + len, u);
         sa.adjust_length(len);
     }
     return sa;
@@ -242,18 +263,93 @@ operator<<(StringAccum& sa, long i)
 StringAccum&
 operator<<(StringAccum& sa, unsigned long u)
 {
-    if (char* x = sa.reserve(24)) {
-        int len = snprintf(x, 24, "%lu", u);
-        sa.adjust_length(len);
-    }
+    if (char* x = sa.reserve(24))
+        sa.adjust_length(unparse_unsigned(x, u));
     return sa;
 }
 
+int
+StringAccum::format_double(char* buf, int n, double d, int precision)
+{
+    // Fast path: values whose exact decimal expansion has at most
+    // 'precision' significant digits and at most 10 fractional digits.
+    // %g prints these exactly, without an exponent.
+    if (d > -1e15 && d < 1e15 && precision >= 1 && precision <= 15
+        && n >= 40) {
+        char* x = buf;
+        bool negative = d < 0 || (d == 0 && 1 / d < 0);
+        if (negative) {
+            *x++ = '-';
+            d = -d;
+        }
+        double ip = floor(d), frac = d - ip;
+        int nsig = (ip > 0 ? unparse_unsigned(x, (unsigned long long) ip) : 0);
+        if (nsig <= precision) {
+            if (ip == 0)
+                *x = '0';
+            x += (nsig ? nsig : 1);
+            if (frac == 0) {
+                *x = '\0';
+                return x - buf;
+            }
+            // frac == m / 2^k exactly, so its decimal expansion is
+            // m * 5^k / 10^k: k digits after the point
+            int k = 0;
+            while (frac != floor(frac) && k <= 10) {
+                frac *= 2;
+                ++k;
+            }
+            if (k <= 10) {
+                unsigned long long m = (unsigned long long) frac;
+                for (int i = 0; i < k; ++i)
+                    m *= 5;
+                char digits[12];
+                for (int i = k - 1; i >= 0; --i, m /= 10)
+                    digits[i] = '0' + m % 10;
+                while (digits[k - 1] == '0')
+                    --k;
+                int lead = 0;
+                if (nsig == 0)
+                    while (digits[lead] == '0')
+                        ++lead;
+                if (nsig + k - lead <= precision) {
+                    *x++ = '.';
+                    memcpy(x, digits, k);
+                    x += k;
+                    *x = '\0';
+                    return x - buf;
+                }
+            }
+        }
+        if (negative)
+            d = -d;
+    }
+    int len = ::snprintf(buf, n, "%.*g", precision, d);
+    return len < n ? len : n - 1;
+}
+
+static int
+double_format_precision(const char* format)
+{
+    // recognize "%.Ng", which format_double() implements
+    if (format[0] != '%' || format[1] != '.' || !isdigit((unsigned char) format[2]))
+        return -1;
+    int precision = 0;
+    for (format += 2; isdigit((unsigned char) *format); ++format)
+        precision = precision * 10 + *format - '0';
+    return format[0] == 'g' && format[1] == 0 ? precision : -1;
+}
+
 StringAccum&
 operator<<(StringAccum& sa, double d)
 {
     if (char* x = sa.reserve(256)) {
-        int len = snprintf(x, 256, StringAccum::double_format, d);
+        int precision = double_format_precision(StringAccum::double_format);
+        int len;
+        if (precision >= 0)
+            len = StringAccum::format_double(x, 256, d, precision);
+        else
+            len = snprintf(x, 256, StringAccum::double_format, d);
         sa.adjust_length(len);
     }
     return sa;
@@ -305,3 +401,23 @@ StringAccum::append_break_lines(const String& text, int linelen, const String& l
         *this << '\n';
     }
 }
+
+void
+StringAccum::append_json_string(const String& str)
+{
+    *this << '\"';
+    for (const char* s = str.begin(); s != str.end(); ++s) {
+        unsigned char c = *s;
+        if (c == '\"' || c == '\\')
+            *this << '\\' << c;
+        else if (c == '\n')
+            *this << "\\n";
+        else if (c == '\t')
+            *this << "\\t";
+        else if (c < 32 || c == 127)
+            snprintf(8, "\\u%04x", c);
+        else
+            *this << c;
+    }
+    *this << '\"';
+}
@@ -247,7 +247,7 @@ String::String(unsigned long x)
 String::String(double x)
 {
     char buf[128];
-    int len = snprintf(buf, sizeof(buf), "%.12g", x);
+    int len = StringAccum::format_double(buf, sizeof(buf), x, 12);
     assign(buf, len, false);
 }
 
@@ -0,0 +1,105 @@
+#! /usr/bin/perl
+# make-glyphlist-db.pl -- compile a glyphlist.txt-format file for otftotfm
+#
+# Usage: perl make-glyphlist-db.pl glyphlist.txt > glyphlist.db
+#
+# Output format (32-bit words in native byte order; see
+# otftotfm/dvipsencoding.cc):
+#   magic version nnames nmap nstringbytes
+#   nnames x (name_offset name_length value), sorted by name
+#   nmap x map word
+#   name strings
+# A value is either a single Unicode code point or, with bit 0x40000000 set,
+# the index of a 0-terminated sequence in the map, where 0x40000000 separates
+# alternatives. The parse follows DvipsEncoding::add_glyphlist exactly.
+use bytes;
+use strict;
+
+my($ALTERNATIVE) = 0x40000000;
+my($MAGIC) = 0x474C4442;
+my($VERSION) = 1;
+
+@ARGV == 1 or die "Usage: make-glyphlist-db.pl FILE\n";
+open(F, "<", $ARGV[0]) or die "$ARGV[0]: $!\n";
+binmode F;
+my($text) = do { local($/); <F> };
+close F;
+
+my(%values, @map);
+my($pos, $len) = (0, length($text));
+
+sub isspace ($) {
+    my($c) = @_;
+    return $c =~ /^[ \t\n\r\f\v]$/;
+}
+
+sub skip_line () {
+    $pos++ while $pos < $len && substr($text, $pos, 1) !~ /^[\n\r]$/;
+}
+
+while ($pos < $len) {
+    $pos++ while $pos < $len && isspace(substr($text, $pos, 1));
+    last if $pos >= $len;
+    if (substr($text, $pos, 1) eq "#") {
+        skip_line();
+        next;
+    }
+    my($name_start) = $pos;
+    $pos++ while $pos < $len && !isspace(substr($text, $pos, 1))
+        && substr($text, $pos, 1) ne ";";
+    if ($pos == $name_start) {
+        skip_line();
+        next;
+    }
+    my($name) = substr($text, $name_start, $pos - $name_start);
+    my(@u, $bad);
+    while (1) {
+        $pos++ while $pos < $len && substr($text, $pos, 1) =~ /^[ \t]$/;
+        my($c) = $pos < $len ? substr($text, $pos, 1) : "";
+        last if $c eq "" || $c eq "\n" || $c eq "\r" || $c eq "#"
+            || (!@u && $c ne ";" && $c ne ",");
+        if ($c eq ";" || $c eq ",") {
+            $pos++;
+            $pos++ while $pos < $len && substr($text, $pos, 1) =~ /^[ \t]$/;
+            if ($pos >= $len || substr($text, $pos, 1) !~ /^[0-9A-Fa-f]$/) {
+                $bad = 1;
+                last;
+            }
+            push @u, $ALTERNATIVE if @u;
+        }
+        my($hex_start) = $pos;
+        $pos++ while $pos < $len && substr($text, $pos, 1) =~ /^[0-9A-Fa-f]$/;
+        my($hex) = substr($text, $hex_start, $pos - $hex_start);
+        # like a uint32_t accumulator, keep only the low 32 bits
+        $hex = substr($hex, -8) if length($hex) > 8;
+        my($v) = hex("0$hex");
+        if ($v == 0 || $v > 0x10FFFF) {
+            $bad = 1;
+            last;
+        }
+        push @u, $v;
+        last if $pos < $len && !isspace(substr($text, $pos, 1))
+            && substr($text, $pos, 1) ne "," && substr($text, $pos, 1) ne ";";
+    }
+    if (!$bad) {
+        if (@u == 1) {
+            $values{$name} = $u[0];
+        } else {
+            $values{$name} = @map | $ALTERNATIVE;
+            push @map, @u, 0;
+        }
+    }
+    skip_line();
+}
+
+my(@names) = sort { $a cmp $b } keys %values;
+my(@entries, $strings);
+$strings = "";
+foreach my $n (@names) {
+    push @entries, length($strings), length($n), $values{$n};
+    $strings .= $n;
+}
+
+binmode STDOUT;
+print pack("L*", $MAGIC, $VERSION, scalar(@names), scalar(@map),
+           length($strings), @entries, @map), $strings;
@@ -1,90 +1,61 @@
 #! /usr/bin/perl -w
 use bytes;
 
-sub P_Cn () { 0; }
-sub P_Lu () { 31; }
-sub P_Ll () { 32; }
-sub P_Lul () { 33; }
-
-my(%propmap) = ('Cn' => P_Cn, 'Co' => 1, 'Cs' => 2, 'Cf' => 3, 'Cc' => 4,
-                'Zs' => 10, 'Zl' => 11, 'Zp' => 12,
-                'Mn' => 20, 'Mc' => 21, 'Me' => 22,
-                'Lo' => 30, 'Lu' => P_Lu, 'Ll' => P_Ll, 'Lul' => P_Lul, 'Lt' => 34, 'Lm' => 35,
-                'No' => 40, 'Nd' => 41, 'Nl' => 42,
-                'Po' => 50, 'Pc' => 51, 'Pd' => 52, 'Ps' => 53, 'Pe' => 54, 'Pi' => 55, 'Pf' => 56,
-                'So' => 60, 'Sm' => 61, 'Sc' => 62, 'Sk' => 63,
+# Values match the UnicodeProperty::P_ constants in otftotfm/uniprop.hh.
+my(%propmap) = ('Cn' => 000, 'Co' => 001, 'Cs' => 002, 'Cf' => 003, 'Cc' => 004,
+                'Zs' => 010, 'Zl' => 011, 'Zp' => 012,
+                'Mn' => 020, 'Mc' => 021, 'Me' => 022,
+                'Lo' => 030, 'Lu' => 031, 'Ll' => 032, 'Lt' => 033, 'Lm' => 034,
+                'No' => 040, 'Nd' => 041, 'Nl' => 042,
+                'Po' => 050, 'Pc' => 051, 'Pd' => 052, 'Ps' => 053, 'Pe' => 054, 'Pi' => 055, 'Pf' => 056,
+                'So' => 060, 'Sm' => 061, 'Sc' => 062, 'Sk' => 063,
                 );
-my(@propinvmap);
-
-{
-    my ($k, $v);
-    while (($k, $v) = each %propmap) {
-        $propinvmap[$v] = $k;
-    }
-}
 
-open(F, "UnicodeData.txt") || die;
+# Usage: perl mkuniprop.pl [UnicodeData.txt] > otftotfm/uniprop.cc
+#
+# Properties are stored in a two-stage table: property_blocks maps each
+# block of 2^block_shift code points to a leaf in property_leaves, which
+# holds each distinct leaf once. The block size is chosen to minimize the
+# tables' total size.
 
-my($last_val, @arr);
-my(%compressed_hash);
-my($all_compressed) = chr(0) . chr(P_Cn);
-$compressed_hash{$all_compressed} = [0, length($all_compressed)];
-my(@offsets);
+my($nuni) = 0x110000;
+my(@prop) = ($propmap{'Cn'}) x $nuni;
 
-sub compress () {
-    my($t) = '';
-    my($v) = -100;
-    for (my $i = 0; $i < 256; $i++) {
-        if ($v != $arr[$i]) {
-            $v = $arr[$i];
-            if ($v == P_Lu && $i < 255 && $arr[$i+1] == P_Ll) {
-                $v = P_Lul;
-                $t .= chr($i) . chr($v);
-                while ($i <= 254 && $arr[$i] == P_Lu && $arr[$i+1] == P_Ll) {
-                    $i += 2;
-                }
-                $i--;
-            } else {
-                $t .= chr($i) . chr($v);
-            }
-        }
+open(F, @ARGV ? $ARGV[0] : "UnicodeData.txt") || die;
+my($range_first);
+while (<F>) {
+    my(@x) = split(/;/, $_);
+    next if @x < 3;
+    my($val) = hex($x[0]);
+    die "prop $x[2]" if !exists($propmap{$x[2]});
+    if ($x[1] =~ /, First>$/) {
+        $range_first = $val;
+    } elsif ($x[1] =~ /, Last>$/ && defined($range_first)) {
+        @prop[$range_first..$val] = ($propmap{$x[2]}) x ($val - $range_first + 1);
+        undef $range_first;
+    } elsif ($val < $nuni) {
+        $prop[$val] = $propmap{$x[2]};
     }
-    $t;
 }
-
-sub out ($$) {
-    my($val, $prop) = @_;
-    if (defined($last_val) && ($val & ~255) != ($last_val & ~255)) {
-        $text = compress();
-        if (!exists($compressed_hash{$text})) {
-            $compressed_hash{$text} = [length($all_compressed), length($all_compressed) + length($text)];
-            $all_compressed .= $text;
-            print "   ";
-            foreach my $short (unpack('n*', $text)) {
-                die "X" . ($short&255) if !defined($propinvmap[int($short&255)]);
-                print " ", int($short>>8), ", P_", $propinvmap[int($short&255)], ",";
-            }
-            print "\n";
-        }
-
-        # now add offsets
-        my($off1, $off2) = @{$compressed_hash{$text}};
-        if (!@offsets || $offsets[-2] != $off1 || $offsets[-1] != $off2) {
-            push(@offsets, ($last_val & ~255), $off1, $off2);
+close F;
+
+my($best_shift, $best_size, $best_leaves, $best_blocks);
+for (my $shift = 5; $shift <= 9; $shift++) {
+    my($bsize) = 1 << $shift;
+    my(%leafmap, @leaves, @blocks);
+    for (my $i = 0; $i < $nuni; $i += $bsize) {
+        my($leaf) = pack("C*", @prop[$i..$i+$bsize-1]);
+        if (!exists($leafmap{$leaf})) {
+            $leafmap{$leaf} = @leaves;
+            push @leaves, $leaf;
         }
-        if ($val >= 0 && ($val & ~255) != (($last_val & ~255) + 256)) {
-            push(@offsets, ($last_val & ~255)+256, 0, 2);
-        }
-
-        undef $last_val;
+        push @blocks, $leafmap{$leaf};
     }
-
-    if (!defined($last_val)) {
-        @arr = (0) x 256;
+    my($size) = @blocks * (@leaves <= 256 ? 1 : 2) + @leaves * $bsize;
+    if (!defined($best_size) || $size < $best_size) {
+        ($best_shift, $best_size, $best_leaves, $best_blocks)
+            = ($shift, $size, [@leaves], [@blocks]);
     }
-    die "prop $prop" if !exists($propmap{$prop});
-    $arr[$val & 255] = $propmap{$prop};
-    $last_val = $val;
 }
 
 print <<"EOD;";
@@ -101,86 +72,40 @@ print <<"EOD;";
  * Public License for more details.
  */
 
+/* Generated by mkuniprop.pl from UnicodeData.txt. */
+
 #include <config.h>
 #include "uniprop.hh"
 #include <lcdf/string.hh>
 
-const unsigned char UnicodeProperty::property_pages[] = {
-    0, P_Cn,
 EOD;
 
-while (<F>) {
-    my(@x) = split(/;/, $_);
-    my($val) = hex($x[0]);
-    out($val, $x[2]);
+printf("enum { block_shift = %d, block_mask = %d };\n\n",
+       $best_shift, (1 << $best_shift) - 1);
+printf("static const %s property_blocks[] = {\n",
+       @$best_leaves <= 256 ? "unsigned char" : "unsigned short");
+for (my $i = 0; $i < @$best_blocks; $i += 16) {
+    my($e) = $i + 15 < @$best_blocks ? $i + 15 : @$best_blocks - 1;
+    print "    ", join(", ", @$best_blocks[$i..$e]), ",\n";
 }
-
-out(0xFFFF, 'Cc');
-
-print "};\nconst unsigned int UnicodeProperty::property_offsets[] = {\n";
-
-for (my $i = 0; $i < @offsets; $i += 3) {
-    printf("    0x%X, %d, %d,\n", $offsets[$i], $offsets[$i+1], $offsets[$i+2]);
+print "};\n\nstatic const unsigned char property_leaves[] = {\n";
+foreach my $leaf (@$best_leaves) {
+    my(@v) = unpack("C*", $leaf);
+    for (my $i = 0; $i < @v; $i += 16) {
+        print "    ", join(", ", @v[$i..$i+15]), ",\n";
+    }
 }
-
 print "};\n";
 
 print <<"EOD;";
-const int UnicodeProperty::nproperty_offsets = (sizeof(UnicodeProperty::property_offsets) / (3*sizeof(unsigned int)));
-
-inline const unsigned int *
-UnicodeProperty::find_offset(uint32_t u)
-{
-    // Up to U+1A00 each page has its own definition.
-    if (u < 0x1A00)
-        return &property_offsets[3*(u >> 8)];
-    // At or after U+1A00, binary search.
-    int l = 0x1A, r = nproperty_offsets - 2;
-    while (l <= r) {
-        int m = (l + r) / 2;
-        const unsigned int *ptr = &property_offsets[3*m];
-        if (u < ptr[0])
-            r = m - 1;
-        else if (u >= ptr[3])
-            l = m + 1;
-        else
-            return ptr;
-    }
-    // If search fails, return last record, which will be all-unassigned.
-    return &property_offsets[3*(nproperty_offsets - 1)];
-}
 
 int
 UnicodeProperty::property(uint32_t u)
 {
-    const unsigned int *offsets = find_offset(u);
-
-    // Now we only care about the last byte.
-    u &= 255;
-
-    // Binary search within record.
-    int l = offsets[1], r = offsets[2] - 4;
-    const unsigned char *the_ptr;
-    while (l <= r) {
-        int m = ((l + r) / 2) & ~1;
-        const unsigned char *ptr = &property_pages[m];
-        if (u < ptr[0])
-            r = m - 2;
-        else if (u >= ptr[2])
-            l = m + 2;
-        else {
-            the_ptr = ptr;
-            goto found_ptr;
-        }
-    }
-    the_ptr = &property_pages[l];
-
-  found_ptr:
-    // Found right block.
-    if (the_ptr[1] == P_Lul)
-        return ((u - the_ptr[0]) % 2 ? P_Ll : P_Lu);
-    else
-        return the_ptr[1];
+    if (u >= 0x110000)
+        return P_Cn;
+    return property_leaves[(property_blocks[u >> block_shift] << block_shift)
+                           + (u & block_mask)];
 }
 
 static const char property_names[] =
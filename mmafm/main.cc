@@ -21,6 +21,7 @@
 #include <efont/afmw.hh>
 #include <efont/amfm.hh>
 #include <lcdf/error.hh>
+#include <lcdf/straccum.hh>
 #include <lcdf/clp.h>
 #include <stdio.h>
 #include <string.h>
@@ -43,6 +44,8 @@
 #define OUTPUT_OPT      310
 #define PRECISION_OPT   311
 #define KERN_PREC_OPT   312
+#define INSTANCE_OPT    313
+#define DIRECTORY_OPT   314
 
 const Clp_Option options[] = {
   { "1", '1', N1_OPT, Clp_ValDouble, 0 },
@@ -59,6 +62,8 @@ const Clp_Option options[] = {
   { "minimum-kern", 'k', KERN_PREC_OPT, Clp_ValDouble, 0 },
   { "kern-precision", 'k', KERN_PREC_OPT, Clp_ValDouble, 0 },
   { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
+  { "instance", 'i', INSTANCE_OPT, Clp_ValString, 0 },
+  { "directory", 'd', DIRECTORY_OPT, Clp_ValString, 0 },
   { "precision", 'p', PRECISION_OPT, Clp_ValInt, 0 },
   { "version", 'v', VERSION_OPT, 0, 0 },
   { "help", 'h', HELP_OPT, 0, 0 },
@@ -74,6 +79,7 @@ static AmfmMetrics *amfm;
 static Vector<PermString> ax_names;
 static Vector<int> ax_nums;
 static Vector<double> values;
+static Vector<Vector<double> > instances;
 
 static void
 set_design(PermString a, double v)
@@ -101,51 +107,6 @@ set_amfm(AmfmMetrics *a)
 }
 
 
-// apply precision
-static inline void
-pround(double &v, double multiplier, double divider)
-{
-  if (KNOWN(v))
-    v = floor(v * multiplier + 0.5) * divider;
-}
-
-static void
-apply_precision(Metrics *m, int precision)
-{
-  if (precision < 0)
-    return;
-
-  double multiplier = 1, divider = 1;
-  for (int i = 0; i < precision; i++)
-    multiplier *= 10, divider /= 10;
-
-  for (int i = 0; i < m->nfd(); i++)
-    pround(m->fd(i), multiplier, divider);
-
-  for (int i = 0; i < m->nglyphs(); i++) {
-    pround(m->wd(i), multiplier, divider);
-    pround(m->lf(i), multiplier, divider);
-    pround(m->bt(i), multiplier, divider);
-    pround(m->rt(i), multiplier, divider);
-    pround(m->tp(i), multiplier, divider);
-  }
-
-  for (int i = 0; i < m->nkv(); i++)
-    pround(m->kv(i), multiplier, divider);
-}
-
-static void
-apply_kern_precision(Metrics *m, double kern_precision)
-{
-  if (kern_precision <= 0)
-    return;
-
-  for (int i = 0; i < m->nkv(); i++)
-    if (fabs(m->kv(i)) < kern_precision)
-      m->kv(i) = 0;
-}
-
-
 static void
 read_file(const char *fn, MetricsFinder *finder)
 {
@@ -205,6 +166,51 @@ read_file(const char *fn, MetricsFinder *finder)
 }
 
 
+static void usage_error(const char *error_message, ...);
+
+static void
+add_instance(const char *s)
+{
+  Vector<double> v;
+  while (*s) {
+    char *end;
+    double x = strtod(s, &end);
+    if (end == s || (*end && *end != ',' && *end != '_'))
+      usage_error("bad %<--instance%> value");
+    v.push_back(x);
+    s = (*end ? end + 1 : end);
+  }
+  if (!v.size())
+    usage_error("bad %<--instance%> value");
+  instances.push_back(v);
+}
+
+static void
+add_comments(Metrics *m)
+{
+  // Add a comment identifying this as interpolated by mmafm
+  if (MetricsXt *xt = m->find_xt("AFM")) {
+    AfmMetricsXt *afm_xt = (AfmMetricsXt *)xt;
+
+#if HAVE_CTIME
+    time_t cur_time = time(0);
+    char *time_str = ctime(&cur_time);
+    int time_len = strlen(time_str) - 1;
+    size_t bufsz = strlen(VERSION) + time_len + 100;
+    char* buf = new char[bufsz];
+    snprintf(buf, bufsz, "Interpolated by mmafm-%s on %.*s.", VERSION,
+             time_len, time_str);
+#else
+    char* buf = new char[strlen(VERSION) + 100];
+    snprintf(buf, strlen(VERSION) + 100, "Interpolated by mmafm-%s.", VERSION);
+#endif
+
+    afm_xt->opening_comments.push_back(buf);
+    afm_xt->opening_comments.push_back("Mmafm is free software.  See <http://www.lcdf.org/type/>.");
+    delete[] buf;
+  }
+}
+
 static void
 usage_error(const char *error_message, ...)
 {
@@ -233,8 +239,14 @@ Each FONT is either an AFM or AMFM file name, or the font name of a multiple\n\
 master font. In the second case, mmafm will find the actual AMFM file using\n\
 the PSRESOURCEPATH environment variable.\n\
 \n\
+With %<--instance%>, mmafm interpolates several instances at once, writing\n\
+each to FONTNAME.afm in the output directory.\n\
+\n\
 General options:\n\
   -o, --output=FILE             Write output to FILE.\n\
+  -i, --instance=N1,N2,...      Interpolate an instance with axis values N1,\n\
+                                N2, .... May be given more than once.\n\
+  -d, --directory=DIR           Write instances into DIR (default \".\").\n\
   -h, --help                    Print this message and exit.\n\
   -v, --version                 Print version number and warranty and exit.\n\
 \n\
@@ -251,6 +263,33 @@ Report bugs to <ekohler@gmail.com>.\n", program_name);
 }
 
 
+static void
+check_weight(MultipleMasterSpace *mmspace, const Vector<double> &design,
+             Vector<double> &weight)
+{
+  if (!mmspace->design_to_weight(design, weight, errh)) {
+    if (!mmspace->check_intermediate()) {
+      errh->message("(I can%,t interpolate font programs with intermediate masters on my own.");
+#if MMAFM_RUN_MMPFB
+      errh->message("I tried to run %<mmpfb --amcp-info %s%>, but it didn't work.", amfm->font_name().c_str());
+      errh->message("Maybe your PSRESOURCEPATH environment variable is not set?");
+#endif
+      errh->fatal("See the manual page for more information.)");
+    } else
+      errh->fatal("can%,t create weight vector");
+  }
+
+  // Need to check for case when all design coordinates are unspecified. The
+  // AMFM file contains a default WeightVector, but often NOT a default
+  // DesignVector; we don't want to generate a file with a FontName like
+  // `MyriadMM_-9.79797979e97_-9.79797979e97_' because the DesignVector
+  // components are unknown.
+  if (!KNOWN(design[0]))
+    errh->fatal("must specify %s%,s %s coordinate", amfm->font_name().c_str(),
+                mmspace->axis_type(0).c_str());
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -268,6 +307,7 @@ main(int argc, char *argv[])
   errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
 
   FILE *output_file = 0;
+  const char *directory = ".";
   int precision = 3;
   double kern_precision = 2.0;
   while (1) {
@@ -316,6 +356,14 @@ main(int argc, char *argv[])
       }
       break;
 
+     case INSTANCE_OPT:
+      add_instance(clp->vstr);
+      break;
+
+     case DIRECTORY_OPT:
+      directory = clp->vstr;
+      break;
+
      case HELP_OPT:
       usage();
       exit(0);
@@ -346,6 +394,8 @@ particular purpose.\n");
 
  done:
   if (!amfm) usage_error("missing font argument");
+  if (output_file && instances.size())
+    usage_error("%<--output%> cannot be combined with %<--instance%>");
 
   MultipleMasterSpace *mmspace = amfm->mmspace();
 #if MMAFM_RUN_MMPFB
@@ -373,58 +423,57 @@ particular purpose.\n");
     else
       mmspace->set_design(design, ax_nums[i], values[i], errh);
 
-  Vector<double> weight;
-  if (!mmspace->design_to_weight(design, weight, errh)) {
-    if (!mmspace->check_intermediate()) {
-      errh->message("(I can%,t interpolate font programs with intermediate masters on my own.");
-#if MMAFM_RUN_MMPFB
-      errh->message("I tried to run %<mmpfb --amcp-info %s%>, but it didn't work.", amfm->font_name().c_str());
-      errh->message("Maybe your PSRESOURCEPATH environment variable is not set?");
-#endif
-      errh->fatal("See the manual page for more information.)");
-    } else
-      errh->fatal("can%,t create weight vector");
+  if (instances.size()) {
+    // Interpolate all instances at once, then write them out.
+    Vector<Vector<double> > designs, weights;
+    for (int i = 0; i < instances.size(); i++) {
+      Vector<double> idesign = design;
+      if (instances[i].size() > idesign.size())
+        errh->warning("instance %d has more than %d axis values", i + 1,
+                      idesign.size());
+      for (int a = 0; a < instances[i].size() && a < idesign.size(); a++)
+        idesign[a] = instances[i][a];
+      Vector<double> weight;
+      check_weight(mmspace, idesign, weight);
+      designs.push_back(idesign);
+      weights.push_back(weight);
+    }
+
+    Vector<Metrics *> ms;
+    if (!amfm->interpolate(designs, weights, ms, errh))
+      return 1;
+    for (int i = 0; i < ms.size(); i++) {
+      Metrics *m = ms[i];
+      add_comments(m);
+      if (precision >= 0)
+        m->round_dimens(precision);
+      if (kern_precision > 0)
+        m->zero_small_kerns(kern_precision);
+
+      StringAccum sa;
+      sa << directory << '/' << m->font_name() << ".afm";
+      if (FILE *f = fopen(sa.c_str(), "wb")) {
+        AfmWriter::write(m, f);
+        fclose(f);
+      } else
+        errh->error("%s: %s", sa.c_str(), strerror(errno));
+      delete m;
+    }
+    return (errh->nerrors() == 0 ? 0 : 1);
   }
 
-  // Need to check for case when all design coordinates are unspecified. The
-  // AMFM file contains a default WeightVector, but often NOT a default
-  // DesignVector; we don't want to generate a file with a FontName like
-  // `MyriadMM_-9.79797979e97_-9.79797979e97_' because the DesignVector
-  // components are unknown.
-  if (!KNOWN(design[0]))
-    errh->fatal("must specify %s%,s %s coordinate", amfm->font_name().c_str(),
-                mmspace->axis_type(0).c_str());
+  Vector<double> weight;
+  check_weight(mmspace, design, weight);
 
   Metrics *m = amfm->interpolate(design, weight, errh);
   if (m) {
-
-    // Add a comment identifying this as interpolated by mmafm
-    if (MetricsXt *xt = m->find_xt("AFM")) {
-      AfmMetricsXt *afm_xt = (AfmMetricsXt *)xt;
-
-#if HAVE_CTIME
-      time_t cur_time = time(0);
-      char *time_str = ctime(&cur_time);
-      int time_len = strlen(time_str) - 1;
-      size_t bufsz = strlen(VERSION) + time_len + 100;
-      char* buf = new char[bufsz];
-      snprintf(buf, bufsz, "Interpolated by mmafm-%s on %.*s.", VERSION,
-               time_len, time_str);
-#else
-      char* buf = new char[strlen(VERSION) + 100];
-      snprintf(buf, strlen(VERSION) + 100, "Interpolated by mmafm-%s.", VERSION);
-#endif
-
-      afm_xt->opening_comments.push_back(buf);
-      afm_xt->opening_comments.push_back("Mmafm is free software.  See <http://www.lcdf.org/type/>.");
-      delete[] buf;
-    }
+    add_comments(m);
 
     // round numbers if necessary
     if (precision >= 0)
-      apply_precision(m, precision);
+      m->round_dimens(precision);
     if (kern_precision > 0)
-      apply_kern_precision(m, kern_precision);
+      m->zero_small_kerns(kern_precision);
 
     // write the output file
     if (!output_file)
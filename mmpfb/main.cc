@@ -17,11 +17,15 @@
 #include <efont/psres.hh>
 #include <efont/t1rw.hh>
 #include <efont/t1mm.hh>
+#include <efont/findmet.hh>
+#include <efont/amfm.hh>
+#include <efont/afmw.hh>
 #include "myfont.hh"
 #include "t1rewrit.hh"
 #include "t1minimize.hh"
 #include <lcdf/clp.h>
 #include <lcdf/error.hh>
+#include <lcdf/straccum.hh>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -54,6 +58,9 @@
 #define PRECISION_OPT   315
 #define SUBRS_OPT       316
 #define MINIMIZE_OPT    317
+#define INSTANCE_OPT    318
+#define DIRECTORY_OPT   319
+#define FONT_METRICS_OPT 320
 
 const Clp_Option options[] = {
   { "1", '1', N1_OPT, Clp_ValDouble, 0 },
@@ -61,7 +68,10 @@ const Clp_Option options[] = {
   { "3", '3', N3_OPT, Clp_ValDouble, 0 },
   { "4", '4', N4_OPT, Clp_ValDouble, 0 },
   { "amcp-info", 0, AMCP_INFO_OPT, 0, 0 },
+  { "directory", 'd', DIRECTORY_OPT, Clp_ValString, 0 },
+  { "font-metrics", 0, FONT_METRICS_OPT, Clp_ValString, 0 },
   { "help", 'h', HELP_OPT, 0, 0 },
+  { "instance", 'i', INSTANCE_OPT, Clp_ValString, 0 },
   { "minimize", 'm', MINIMIZE_OPT, 0, Clp_Negate },
   { "optical-size", 'O', OPSIZE_OPT, Clp_ValDouble, 0 },
   { "output", 'o', OUTPUT_OPT, Clp_ValString, 0 },
@@ -82,6 +92,7 @@ using namespace Efont;
 
 static const char *program_name;
 static ErrorHandler *errh;
+static String font_data;
 static MyFont *font;
 static MultipleMasterSpace *mmspace;
 
@@ -89,6 +100,9 @@ static Vector<PermString> ax_names;
 static Vector<int> ax_nums;
 static Vector<double> values;
 
+static Vector<Vector<double> > instances;
+
+
 
 void
 usage_error(const char *error_message, ...)
@@ -112,6 +126,8 @@ usage()
 %<Mmpfb%> creates a single-master PostScript Type 1 font by interpolating a\n\
 multiple master font at a point you specify. The resulting font does not\n\
 contain multiple master extensions. It is written to the standard output.\n\
+With %<--instance%>, mmpfb creates several instances at once, writing each to\n\
+its own file.\n\
 \n\
 Usage: %s [OPTION]... FONT\n\
 \n\
@@ -127,6 +143,11 @@ General options:\n\
   -p, --precision=N            Set precision to N (larger means more precise).\n\
       --subrs=N                Limit output font to at most N subroutines.\n\
       --no-minimize            Do not replace original font%,s PostScript code.\n\
+  -i, --instance=N1,N2,...     Create an instance with axis values N1, N2, ....\n\
+                               May be given more than once.\n\
+  -d, --directory=DIR          Write instances into DIR (default \".\").\n\
+      --font-metrics=FILE      Also write instance AFMs interpolated from\n\
+                               AMFM FILE.\n\
   -h, --help                   Print this message and exit.\n\
   -q, --quiet                  Do not generate any error messages.\n\
   -v, --version                Print version number and exit.\n\
@@ -158,6 +179,27 @@ set_design(int a, double v)
   values.push_back(v);
 }
 
+static MyFont *
+read_font(const char *filename, MultipleMasterSpace **mmspace_store)
+{
+  Type1StringReader reader(font_data);
+  MyFont *f = new MyFont(reader);
+  if (!f->ok())
+      errh->fatal("%s: invalid font", filename);
+  else if (f->nglyphs() == 0)
+      errh->fatal("%s: font contains no characters", filename);
+
+  MultipleMasterSpace *mms = f->create_mmspace(errh);
+  if (!mms)
+    errh->fatal("%s: not a multiple master font", filename);
+  if (mmspace_store)
+    *mmspace_store = mms;
+
+  f->undo_synthetic();
+  return f;
+}
+
+
 void
 do_file(const char *filename, PsresDatabase *psres)
 {
@@ -191,28 +233,131 @@ do_file(const char *filename, PsresDatabase *psres)
   if (!f)
     errh->fatal("%s: %s", filename, strerror(errno));
 
-  Type1Reader *reader;
-  int c = getc(f);
-  ungetc(c, f);
-  if (c == EOF)
+  // Keep the font file in memory so each instance can be parsed from it.
+  StringAccum sa;
+  int amt;
+  do {
+    if (char *x = sa.reserve(32768)) {
+      amt = fread(x, 1, 32768, f);
+      sa.adjust_length(amt);
+    } else
+      amt = 0;
+  } while (amt != 0);
+  if (f != stdin)
+    fclose(f);
+  font_data = sa.take_string();
+  if (!font_data)
     errh->fatal("%s: empty file", filename);
-  if (c == 128)
-    reader = new Type1PFBReader(f);
-  else
-    reader = new Type1PFAReader(f);
 
-  font = new MyFont(*reader);
-  delete reader;
-  if (!font->ok())
-      errh->fatal("%s: invalid font", filename);
-  else if (font->nglyphs() == 0)
-      errh->fatal("%s: font contains no characters", filename);
+  font = read_font(filename, &mmspace);
+}
 
-  mmspace = font->create_mmspace(errh);
-  if (!mmspace)
-    errh->fatal("%s: not a multiple master font", filename);
 
-  font->undo_synthetic();
+static void
+add_instance(const char *s)
+{
+  Vector<double> v;
+  while (*s) {
+    char *end;
+    double x = strtod(s, &end);
+    if (end == s || (*end && *end != ',' && *end != '_'))
+      usage_error("bad %<--instance%> value");
+    v.push_back(x);
+    s = (*end ? end + 1 : end);
+  }
+  if (!v.size())
+    usage_error("bad %<--instance%> value");
+  instances.push_back(v);
+}
+
+static Type1Font *
+make_instance(MyFont *font, MultipleMasterSpace *mmspace,
+              const Vector<double> &design, bool minimize, int precision,
+              int subr_count)
+{
+  if (!font->set_design_vector(mmspace, design, errh))
+    exit(1);
+
+  font->interpolate_dicts(minimize, errh);
+  font->interpolate_charstrings(precision, errh);
+
+  if (subr_count >= 0) {
+      Type1SubrRemover sr(font, errh);
+      sr.run(subr_count);
+  }
+
+  font->fill_in_subrs();
+
+  Type1Font *t1font;
+  if (minimize) {
+      t1font = ::minimize(font);
+      delete font;
+  } else
+      t1font = font;
+
+  { // Add an identifying comment.
+#if HAVE_CTIME
+    time_t cur_time = time(0);
+    char *time_str = ctime(&cur_time);
+    int time_len = strlen(time_str) - 1;
+    size_t bufsz = strlen(VERSION) + time_len + 100;
+    char* buf = new char[bufsz];
+    snprintf(buf, bufsz, "%%%% Interpolated by mmpfb-%s on %.*s.", VERSION,
+             time_len, time_str);
+#else
+    char* buf = new char[strlen(VERSION) + 100];
+    snprintf(buf, strlen(VERSION) + 100, "%%%% Interpolated by mmpfb-%s.", VERSION);
+#endif
+
+    t1font->add_header_comment(buf);
+    t1font->add_header_comment("%% Mmpfb is free software.  See <http://www.lcdf.org/type/>.");
+    delete[] buf;
+  }
+
+  return t1font;
+}
+
+static void
+write_font(Type1Font *t1font, FILE *outfile, bool write_pfb)
+{
+  if (write_pfb) {
+#if defined(_MSDOS) || defined(_WIN32)
+    _setmode(_fileno(outfile), _O_BINARY);
+#endif
+    Type1PFBWriter w(outfile);
+    t1font->write(w);
+  } else {
+    Type1PFAWriter w(outfile);
+    t1font->write(w);
+  }
+}
+
+static FILE *
+open_instance_file(const char *directory, PermString name, const char *suffix)
+{
+  StringAccum sa;
+  sa << directory << '/' << name << suffix;
+  FILE *f = fopen(sa.c_str(), "wb");
+  if (!f)
+    errh->error("%s: %s", sa.c_str(), strerror(errno));
+  return f;
+}
+
+static void
+write_instance_afm(AmfmMetrics *amfm, const Vector<double> &design,
+                   const Vector<double> &weight, const char *directory)
+{
+  Metrics *m = amfm->interpolate(design, weight, errh);
+  if (!m)
+    return;
+  // same rounding as mmafm's defaults
+  m->round_dimens(3);
+  m->zero_small_kerns(2.0);
+  if (FILE *f = open_instance_file(directory, m->font_name(), ".afm")) {
+    AfmWriter::write(m, f);
+    fclose(f);
+  }
+  delete m;
 }
 
 
@@ -270,6 +415,8 @@ main(int argc, char *argv[])
   int precision = 5;
   int subr_count = -1;
   FILE *outfile = 0;
+  const char *directory = ".";
+  const char *amfm_file = 0;
   ::errh =
       ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
 
@@ -336,6 +483,18 @@ main(int argc, char *argv[])
         minimize = !clp->negated;
         break;
 
+     case INSTANCE_OPT:
+      add_instance(clp->vstr);
+      break;
+
+     case DIRECTORY_OPT:
+      directory = clp->vstr;
+      break;
+
+     case FONT_METRICS_OPT:
+      amfm_file = clp->vstr;
+      break;
+
      case QUIET_OPT:
        if (clp->negated)
            errh = ErrorHandler::default_handler();
@@ -388,6 +547,8 @@ particular purpose.\n");
   }
 
  done:
+  if (outfile && instances.size())
+      usage_error("%<--output%> cannot be combined with %<--instance%>");
   if (outfile == 0)
       outfile = stdout;
 
@@ -411,55 +572,55 @@ particular purpose.\n");
       design[i] = default_design[i];
     }
 
-  if (!font->set_design_vector(mmspace, design, errh))
-    exit(1);
 
-  font->interpolate_dicts(minimize, errh);
-  font->interpolate_charstrings(precision, errh);
-
-  if (subr_count >= 0) {
-      Type1SubrRemover sr(font, errh);
-      sr.run(subr_count);
+  if (!instances.size()) {
+    Type1Font *t1font = make_instance(font, mmspace, design, minimize,
+                                      precision, subr_count);
+    write_font(t1font, outfile, write_pfb);
+    return 0;
   }
 
-  font->fill_in_subrs();
-
-  Type1Font *t1font;
-  if (minimize) {
-      t1font = ::minimize(font);
-      delete font;
-  } else
-      t1font = font;
-
-  { // Add an identifying comment.
-#if HAVE_CTIME
-    time_t cur_time = time(0);
-    char *time_str = ctime(&cur_time);
-    int time_len = strlen(time_str) - 1;
-    size_t bufsz = strlen(VERSION) + time_len + 100;
-    char* buf = new char[bufsz];
-    snprintf(buf, bufsz, "%%%% Interpolated by mmpfb-%s on %.*s.", VERSION,
-             time_len, time_str);
-#else
-    char* buf = new char[strlen(VERSION) + 100];
-    snprintf(buf, strlen(VERSION) + 100, "%%%% Interpolated by mmpfb-%s.", VERSION);
-#endif
-
-    t1font->add_header_comment(buf);
-    t1font->add_header_comment("%% Mmpfb is free software.  See <http://www.lcdf.org/type/>.");
-    delete[] buf;
+  // Multiple instances: each is interpolated from a fresh copy of the font,
+  // parsed from the in-memory font file. Charstring interpolation is not
+  // shared between instances; Type1MMRemover rewrites the font in place.
+  AmfmMetrics *amfm = 0;
+  if (amfm_file) {
+    PsresDatabase *psres = new PsresDatabase;
+    psres->add_psres_path(getenv("PSRESOURCEPATH"), 0, false);
+    MetricsFinder *finder = new CacheMetricsFinder;
+    Filename amfm_fn(amfm_file);
+    finder->add_finder(new DirectoryMetricsFinder(amfm_fn.directory()));
+    finder->add_finder(new PsresMetricsFinder(psres));
+    amfm = AmfmReader::read(amfm_fn, finder, errh);
+    if (!amfm)
+      errh->fatal("%s: can%,t read AMFM file", amfm_file);
   }
 
-  if (write_pfb) {
-#if defined(_MSDOS) || defined(_WIN32)
-    _setmode(_fileno(outfile), _O_BINARY);
-#endif
-    Type1PFBWriter w(outfile);
-    t1font->write(w);
-  } else {
-    Type1PFAWriter w(outfile);
-    t1font->write(w);
+  for (int i = 0; i < instances.size(); i++) {
+    Vector<double> idesign = design;
+    if (instances[i].size() > idesign.size())
+      errh->warning("instance %d has more than %d axis values", i + 1,
+                    idesign.size());
+    for (int a = 0; a < instances[i].size() && a < idesign.size(); a++)
+      idesign[a] = instances[i][a];
+
+    Vector<double> weight;
+    if (amfm && !mmspace->design_to_weight(idesign, weight, errh))
+      errh->fatal("can%,t create weight vector");
+
+    MyFont *ifont = read_font(font->font_name().c_str(), 0);
+    Type1Font *t1font = make_instance(ifont, mmspace, idesign, minimize,
+                                      precision, subr_count);
+    if (FILE *f = open_instance_file(directory, t1font->font_name(),
+                                     write_pfb ? ".pfb" : ".pfa")) {
+      write_font(t1font, f, write_pfb);
+      fclose(f);
+    }
+    delete t1font;
+
+    if (amfm)
+      write_instance_afm(amfm, idesign, weight, directory);
   }
 
-  return 0;
+  return (errh->nerrors() == 0 ? 0 : 1);
 }
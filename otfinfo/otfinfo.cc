@@ -15,6 +15,7 @@
 # include <config.h>
 #endif
 #include <efont/psres.hh>
+#include <efont/fontindex.hh>
 #include <efont/otfcmap.hh>
 #include <efont/otffvar.hh>
 #include <efont/otfgsub.hh>
@@ -33,6 +34,7 @@
 #include <stdarg.h>
 #include <ctype.h>
 #include <errno.h>
+#include <sys/stat.h>
 #include <algorithm>
 #include <utility>
 #ifdef HAVE_UNISTD_H
@@ -50,6 +52,9 @@ using namespace Efont;
 #define QUIET_OPT               303
 #define VERBOSE_OPT             304
 #define SCRIPT_OPT              305
+#define RECURSIVE_OPT           306
+#define FILES_FROM_OPT          307
+#define LOOKUP_INDEX_OPT        308
 
 #define QUERY_SCRIPTS_OPT       320
 #define QUERY_FEATURES_OPT      321
@@ -63,6 +68,8 @@ using namespace Efont;
 #define DUMP_TABLE_OPT          329
 #define QUERY_UNICODE_OPT       330
 #define QUERY_VARIABLE_OPT      331
+#define JSON_SUMMARY_OPT        332
+#define BUILD_INDEX_OPT         333
 
 const Clp_Option options[] = {
     { "script", 0, SCRIPT_OPT, Clp_ValString, 0 },
@@ -82,6 +89,11 @@ const Clp_Option options[] = {
     { "unicode", 'u', QUERY_UNICODE_OPT, 0, 0 },
     { "variable", 0, QUERY_VARIABLE_OPT, 0, 0 },
     { "variations", 0, QUERY_VARIABLE_OPT, 0, 0 },
+    { "json-summary", 0, JSON_SUMMARY_OPT, 0, 0 },
+    { "recursive", 'r', RECURSIVE_OPT, 0, Clp_Negate },
+    { "files-from", 0, FILES_FROM_OPT, Clp_ValString, 0 },
+    { "lookup-index", 0, LOOKUP_INDEX_OPT, Clp_ValString, 0 },
+    { "build-index", 0, BUILD_INDEX_OPT, Clp_ValString, 0 },
     { "help", 'h', HELP_OPT, 0, 0 },
     { "version", 0, VERSION_OPT, 0, 0 },
 };
@@ -133,9 +145,15 @@ Query options:\n\
   -u, --unicode                Report font%,s supported Unicode code points.\n\
       --variable               Report variable font information.\n\
   -T, --dump-table NAME        Output font%,s %<NAME%> table.\n\
+      --json-summary           Report a one-line JSON summary of each font.\n\
+      --build-index=FILE       Add fonts to font index FILE and refresh it.\n\
 \n\
 Other options:\n\
       --script=SCRIPT[.LANG]   Set script used for --features [latn].\n\
+  -r, --recursive              Search directory arguments for fonts.\n\
+      --files-from=FILE        Read font file names from FILE, one per line.\n\
+      --lookup-index=FILE      Look up arguments by PostScript or family name\n\
+                               in font index FILE.\n\
   -V, --verbose                Print progress information to standard error.\n\
   -h, --help                   Print this message and exit.\n\
   -q, --quiet                  Do not generate any error messages.\n\
@@ -665,17 +683,213 @@ do_dump_table(const OpenType::Font &otf, OpenType::Tag tag, ErrorHandler *errh)
     }
 }
 
+static void
+append_json_strings(StringAccum &sa, Vector<String> &v)
+{
+    std::sort(v.begin(), v.end());
+    String *end = std::unique(v.begin(), v.end());
+    sa << '[';
+    for (String *sp = v.begin(); sp != end; ++sp) {
+        if (sp != v.begin())
+            sa << ',';
+        sa.append_json_string(*sp);
+    }
+    sa << ']';
+}
+
+static void
+do_inventory(const OpenType::Font &otf, const String &filename, ErrorHandler *errh)
+{
+    StringAccum sa;
+    sa << "{\"file\":";
+    sa.append_json_string(filename);
+
+    try {
+        String name_table = otf.table("name");
+        OpenType::Name name(name_table, errh);
+        if (name_table && name.ok()) {
+            static const struct { const char *key; int nameid; } names[] = {
+                { "family", OpenType::Name::N_FAMILY },
+                { "subfamily", OpenType::Name::N_SUBFAMILY },
+                { "full_name", OpenType::Name::N_FULLNAME },
+                { "postscript_name", OpenType::Name::N_POSTSCRIPT },
+                { "version", OpenType::Name::N_VERSION }
+            };
+            for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+                if (String s = name.english_name(names[i].nameid)) {
+                    sa << ",\"" << names[i].key << "\":";
+                    sa.append_json_string(s);
+                }
+        }
+    } catch (OpenType::Error) {
+    }
+
+    try {
+        OpenType::Data maxp(otf.table("maxp"));
+        if (maxp.length() >= 6)
+            sa << ",\"glyphs\":" << maxp.u16(4);
+    } catch (OpenType::Error) {
+    }
+
+    Vector<String> tables;
+    for (int i = 0; i < otf.ntables(); i++)
+        if (OpenType::Tag tag = otf.table_tag(i))
+            tables.push_back(tag.text());
+    sa << ",\"tables\":";
+    append_json_strings(sa, tables);
+
+    Vector<String> scripts, features;
+    Vector<OpenType::Tag> feature_tags;
+    FontIndex::collect_layout(otf, scripts, feature_tags, errh);
+    for (OpenType::Tag *tp = feature_tags.begin(); tp != feature_tags.end(); ++tp)
+        features.push_back(tp->text());
+    sa << ",\"scripts\":";
+    append_json_strings(sa, scripts);
+    sa << ",\"features\":";
+    append_json_strings(sa, features);
+
+    try {
+        String os2_table = otf.table("OS/2");
+        if (!os2_table)
+            throw OpenType::Error();
+        OpenType::Os2 os2(os2_table, errh);
+        if (os2.ok() && os2.has_optical_point_size())
+            sa << ",\"optical_size\":[" << os2.lower_optical_point_size()
+               << ',' << os2.upper_optical_point_size() << ']';
+    } catch (OpenType::Error) {
+    }
+
+    try {
+        String cmap_table = otf.table("cmap");
+        if (!cmap_table)
+            throw OpenType::Error();
+        OpenType::Cmap cmap(cmap_table, errh);
+        if (cmap.ok()) {
+            Vector<std::pair<uint32_t, OpenType::Glyph> > u2g;
+            cmap.unmap_all(u2g);
+            std::sort(u2g.begin(), u2g.end());
+            int n = 0, nbmp = 0;
+            uint32_t first = 0, last = 0;
+            for (int i = 0; i < u2g.size(); ++i)
+                if (u2g[i].second != 0
+                    && (n == 0 || u2g[i].first != last)) {
+                    if (n == 0)
+                        first = u2g[i].first;
+                    last = u2g[i].first;
+                    ++n;
+                    nbmp += last < 0x10000;
+                }
+            sa << ",\"unicode\":{\"count\":" << n << ",\"bmp\":" << nbmp;
+            if (n)
+                sa.snprintf(40, ",\"first\":\"U+%04X\",\"last\":\"U+%04X\"",
+                            first, last);
+            sa << '}';
+        }
+    } catch (OpenType::Error) {
+    }
+
+    try {
+        if (String fvar_table = otf.table("fvar")) {
+            OpenType::Fvar fvar(fvar_table);
+            sa << ",\"axes\":[";
+            for (int i = 0; i != fvar.naxes(); ++i) {
+                OpenType::Axis ax = fvar.axis(i);
+                sa << (i ? "," : "") << "{\"tag\":";
+                sa.append_json_string(ax.tag().text());
+                sa << ",\"min\":" << ax.min_value()
+                   << ",\"default\":" << ax.default_value()
+                   << ",\"max\":" << ax.max_value() << '}';
+            }
+            sa << ']';
+        }
+    } catch (OpenType::Error) {
+    }
+
+    sa << "}\n";
+    fwrite(sa.data(), 1, sa.length(), stdout);
+}
+
+static void
+add_input_path(const String &path, bool recursive, Vector<String> &input_files, ErrorHandler *errh)
+{
+    struct stat st;
+    if (recursive && path != "-" && stat(path.c_str(), &st) == 0
+        && S_ISDIR(st.st_mode))
+        FontIndex::find_fonts(path, input_files, errh);
+    else
+        input_files.push_back(path);
+}
+
+static void
+add_input_file_list(const String &filename, bool recursive, Vector<String> &input_files, ErrorHandler *errh)
+{
+    String text = read_file(filename, errh);
+    const char *s = text.begin(), *end = text.end();
+    while (s != end) {
+        const char *nl = std::find(s, end, '\n');
+        const char *line_end = nl;
+        if (line_end != s && line_end[-1] == '\r')
+            --line_end;
+        if (line_end != s)
+            add_input_path(text.substring(s, line_end), recursive, input_files, errh);
+        s = nl + (nl != end);
+    }
+}
+
+static void
+resolve_indexed_paths(const FontIndex &index, Vector<String> &input_paths)
+{
+    Vector<String> paths;
+    Vector<int> matches;
+    for (String *sp = input_paths.begin(); sp != input_paths.end(); ++sp) {
+        int i = index.find_postscript_name(*sp);
+        if (i >= 0)
+            paths.push_back(index[i].filename);
+        else {
+            index.find_family(*sp, matches);
+            if (matches.size())
+                for (int *ip = matches.begin(); ip != matches.end(); ++ip)
+                    paths.push_back(index[*ip].filename);
+            else
+                paths.push_back(*sp);
+        }
+    }
+    input_paths.swap(paths);
+}
+
+static void
+do_build_index(const String &index_file, const Vector<String> &input_files, ErrorHandler *errh)
+{
+    FontIndex index;
+    struct stat st;
+    if (stat(index_file.c_str(), &st) == 0 && !index.read(index_file, errh))
+        return;
+    int nchanged = index.refresh(errh);
+    int nfonts = index.size();
+    for (const String *sp = input_files.begin(); sp != input_files.end(); ++sp)
+        if (*sp != "-")
+            index.add_font(*sp, errh);
+    if (index.write(index_file, errh) && verbose)
+        errh->message("%s: %d fonts (%d added, %d refreshed or removed)",
+                      index_file.c_str(), index.size(),
+                      index.size() - nfonts, nchanged);
+}
+
 int
 main(int argc, char *argv[])
 {
     Clp_Parser *clp =
         Clp_NewParser(argc, (const char * const *)argv, sizeof(options) / sizeof(options[0]), options);
+    Clp_SetResponseFiles(clp, 1);
     program_name = Clp_ProgramName(clp);
 
     ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
-    Vector<const char *> input_files;
+    Vector<String> input_paths;
+    Vector<String> file_lists;
     OpenType::Tag dump_table;
+    String index_file, build_index_file;
     int query = 0;
+    bool recursive = false;
 
     while (1) {
         int opt = Clp_Next(clp);
@@ -710,6 +924,7 @@ main(int argc, char *argv[])
           case QUERY_FVERSION_OPT:
         case QUERY_UNICODE_OPT:
         case QUERY_VARIABLE_OPT:
+        case JSON_SUMMARY_OPT:
           case TABLES_OPT:
           case INFO_OPT:
             if (query)
@@ -717,6 +932,13 @@ main(int argc, char *argv[])
             query = opt;
             break;
 
+        case BUILD_INDEX_OPT:
+            if (query)
+                usage_error(errh, "supply exactly one query type option");
+            build_index_file = clp->vstr;
+            query = opt;
+            break;
+
         case DUMP_TABLE_OPT:
             if (query)
                 usage_error(errh, "supply exactly one query type option");
@@ -736,6 +958,18 @@ main(int argc, char *argv[])
             verbose = !clp->negated;
             break;
 
+          case RECURSIVE_OPT:
+            recursive = !clp->negated;
+            break;
+
+          case FILES_FROM_OPT:
+            file_lists.push_back(clp->vstr);
+            break;
+
+          case LOOKUP_INDEX_OPT:
+            index_file = clp->vstr;
+            break;
+
           case VERSION_OPT:
             printf("otfinfo (LCDF typetools) %s\n", VERSION);
             printf("Copyright (C) 2003-2023 Eddie Kohler\n\
@@ -751,7 +985,7 @@ particular purpose.\n");
             break;
 
           case Clp_NotOption:
-            input_files.push_back(clp->vstr);
+            input_paths.push_back(clp->vstr);
             break;
 
           case Clp_Done:
@@ -770,13 +1004,31 @@ particular purpose.\n");
   done:
     if (!query)
         usage_error(errh, "supply exactly one query option");
-    if (!input_files.size())
+    if (query == BUILD_INDEX_OPT)
+        recursive = true;
+    else if (index_file) {
+        FontIndex index;
+        if (!index.read(index_file, errh))
+            exit(1);
+        resolve_indexed_paths(index, input_paths);
+    }
+    Vector<String> input_files;
+    for (String *sp = file_lists.begin(); sp != file_lists.end(); ++sp)
+        add_input_file_list(*sp, recursive, input_files, errh);
+    for (String *sp = input_paths.begin(); sp != input_paths.end(); ++sp)
+        add_input_path(*sp, recursive, input_files, errh);
+    if (!input_files.size() && !input_paths.size() && !file_lists.size())
         input_files.push_back("-");
     if (script.null())
         script = Efont::OpenType::Tag("latn");
+    if (query == BUILD_INDEX_OPT) {
+        do_build_index(build_index_file, input_files, errh);
+        Clp_DeleteParser(clp);
+        return (errh->nerrors() == 0 ? 0 : 1);
+    }
 
     FileErrorHandler stdout_errh(stdout);
-    for (const char **input_filep = input_files.begin(); input_filep != input_files.end(); input_filep++) {
+    for (String *input_filep = input_files.begin(); input_filep != input_files.end(); input_filep++) {
         int before_nerrors = errh->nerrors();
         String font_data = read_file(*input_filep, errh);
         if (errh->nerrors() != before_nerrors)
@@ -814,6 +1066,8 @@ particular purpose.\n");
             do_dump_table(otf, dump_table, &cerrh);
         else if (query == INFO_OPT)
             do_info(otf, &cerrh, result_errh);
+        else if (query == JSON_SUMMARY_OPT)
+            do_inventory(otf, input_file, &cerrh);
     }
 
     Clp_DeleteParser(clp);
@@ -33,6 +33,7 @@
 #endif
 #include <lcdf/error.hh>
 #include <lcdf/straccum.hh>
+#include <lcdf/hashmap.hh>
 #if HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
@@ -784,20 +785,9 @@ update_autofont_map(const String &fontname, String mapline, ErrorHandler *errh)
     return 0;
 }
 
-String
-locate_encoding(String encfile, ErrorHandler *errh, bool literal)
+static String
+locate_encoding_x(String encfile, ErrorHandler *errh)
 {
-    if (!encfile || encfile == "-")
-        return encfile;
-
-    if (!literal) {
-        int slash = encfile.find_right('/');
-        int dot = encfile.find_left('.', slash >= 0 ? slash : 0);
-        if (dot < 0)
-            if (String file = locate_encoding(encfile + ".enc", errh, true))
-                return file;
-    }
-
 #if HAVE_KPATHSEA
     if (String file = kpsei_string(kpsei_find_file(encfile.c_str(), KPSEI_FMT_ENCODING))) {
         if (verbose)
@@ -805,6 +795,8 @@ locate_encoding(String encfile, ErrorHandler *errh, bool literal)
         return file;
     } else if (verbose)
         errh->message("encoding file %s not found with kpathsea", encfile.c_str());
+#else
+    (void) errh;
 #endif
 
     if (access(encfile.c_str(), R_OK) >= 0)
@@ -812,3 +804,28 @@ locate_encoding(String encfile, ErrorHandler *errh, bool literal)
     else
         return String();
 }
+
+String
+locate_encoding(String encfile, ErrorHandler *errh, bool literal)
+{
+    if (!encfile || encfile == "-")
+        return encfile;
+
+    // remember earlier searches; base encodings often repeat a file
+    static HashMap<String, String> located;
+    String key = (literal ? "L" : "N") + encfile;
+    if (String *file = located.findp(key))
+        return *file;
+
+    String file;
+    if (!literal) {
+        int slash = encfile.find_right('/');
+        int dot = encfile.find_left('.', slash >= 0 ? slash : 0);
+        if (dot < 0)
+            file = locate_encoding(encfile + ".enc", errh, true);
+    }
+    if (!file)
+        file = locate_encoding_x(encfile, errh);
+    located.insert(key, file);
+    return file;
+}
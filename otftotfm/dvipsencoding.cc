@@ -19,6 +19,8 @@
 #include "secondary.hh"
 #include <lcdf/error.hh>
 #include <lcdf/straccum.hh>
+#include <lcdf/md5.h>
+#include <lcdf/cachefile.hh>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
@@ -30,16 +32,114 @@ enum { GLYPHLIST_ALTERNATIVE = 0x40000000,
        GLYPHLIST_USEMAP = GLYPHLIST_ALTERNATIVE,
        U_EMPTYSLOT = 0xD801,
        U_ALTSELECTOR = 0xD802 };
-static HashMap<String, uint32_t> glyphlist((uint32_t) -1);
-static Vector<uint32_t> glyphmap;
+
+// A glyph list is either parsed from text into 'glyphlist' and 'glyphmap',
+// or compiled by make-glyphlist-db.pl and queried in place. Later glyph
+// lists override earlier ones.
+namespace {
+class Glyphlist { public:
+    Glyphlist()
+        : glyphlist((uint32_t) -1), _names(0), _map(0), _strings(0),
+          _nnames(0) {
+    }
+    bool set_compiled(const String &data);
+    int find(const String &name, const uint32_t *&map) const;
+    bool compiled() const               { return _names != 0; }
+
+    HashMap<String, uint32_t> glyphlist;
+    Vector<uint32_t> glyphmap;
+
+  private:
+    String _data;
+    const uint32_t *_names;
+    const uint32_t *_map;
+    const char *_strings;
+    int _nnames;
+};
+}
+
+enum { GLYPHLIST_DB_MAGIC = 0x474C4442, GLYPHLIST_DB_VERSION = 1 };
+static Vector<Glyphlist *> glyphlists;
 static PermString::Initializer perm_initializer;
 PermString DvipsEncoding::dot_notdef(".notdef");
 
 #define NEXT_GLYPH_NAME(gn)     ("/" + (gn))
 
+bool
+Glyphlist::set_compiled(const String &data)
+{
+    // the database is aligned since String data comes from malloc
+    const uint32_t *w = reinterpret_cast<const uint32_t *>(data.data());
+    if (data.length() < 20 || (reinterpret_cast<uintptr_t>(w) & 3)
+        || w[0] != GLYPHLIST_DB_MAGIC || w[1] != GLYPHLIST_DB_VERSION)
+        return false;
+    uint32_t nnames = w[2], nmap = w[3], nstrings = w[4];
+    if (nnames > 0x1000000 || nmap > 0x1000000 || nstrings > 0x10000000
+        || (uint32_t) data.length() != 20 + nnames * 12 + nmap * 4 + nstrings
+        || (nmap && w[5 + nnames * 3 + nmap - 1] != 0))
+        return false;
+    for (uint32_t i = 0; i < nnames; ++i) {
+        const uint32_t *e = w + 5 + i * 3;
+        if (e[0] > nstrings || e[1] > nstrings - e[0]
+            || ((e[2] & GLYPHLIST_USEMAP)
+                && (e[2] & ~GLYPHLIST_USEMAP) >= nmap))
+            return false;
+    }
+    _data = data;
+    _names = w + 5;
+    _map = _names + nnames * 3;
+    _strings = reinterpret_cast<const char *>(_map + nmap);
+    _nnames = nnames;
+    return true;
+}
+
+int
+Glyphlist::find(const String &name, const uint32_t *&map) const
+{
+    if (!_names) {
+        map = glyphmap.begin();
+        return glyphlist[name];
+    }
+    map = _map;
+    int l = 0, r = _nnames - 1;
+    while (l <= r) {
+        int m = (l + r) / 2;
+        const uint32_t *e = _names + m * 3;
+        int len = (int) e[1] < name.length() ? e[1] : name.length();
+        int cmp = memcmp(_strings + e[0], name.data(), len);
+        if (cmp == 0)
+            cmp = (int) e[1] - name.length();
+        if (cmp == 0)
+            return e[2];
+        else if (cmp < 0)
+            l = m + 1;
+        else
+            r = m - 1;
+    }
+    return -1;
+}
+
+
+bool
+DvipsEncoding::add_glyphlist_database(const String &data)
+{
+    Glyphlist *gl = new Glyphlist;
+    if (!gl->set_compiled(data)) {
+        delete gl;
+        return false;
+    }
+    glyphlists.push_back(gl);
+    return true;
+}
+
 void
 DvipsEncoding::add_glyphlist(String text)
 {
+    if (!glyphlists.size() || glyphlists.back()->compiled())
+        glyphlists.push_back(new Glyphlist);
+    HashMap<String, uint32_t> &glyphlist = glyphlists.back()->glyphlist;
+    Vector<uint32_t> &glyphmap = glyphlists.back()->glyphmap;
+
     const char *s = text.begin(), *end = text.end();
     while (s != end) {
         // move to first nonblank
@@ -141,8 +241,11 @@ DvipsEncoding::glyphname_unicode(String gn, Vector<uint32_t> &unis)
             return false;
     }
 
-    // check glyphlist
-    int value = glyphlist[component];
+    // check glyphlists, newest first
+    int value = -1;
+    const uint32_t *glyphmap = 0;
+    for (int i = glyphlists.size() - 1; i >= 0 && value < 0; --i)
+        value = glyphlists[i]->find(component, glyphmap);
     uint32_t uval;
     if (value >= 0 && !(value & GLYPHLIST_USEMAP))
         unis.push_back(value);
@@ -612,6 +715,38 @@ trim_space(const String &s, int pos)
     return s.substring(pos, epos - pos);
 }
 
+namespace {
+class CountingErrorHandler : public ErrorVeneer { public:
+    CountingErrorHandler(ErrorHandler *errh)
+        : ErrorVeneer(errh), _ndiagnostics(0) {
+    }
+    void account(int level) {
+        if (level <= el_warning)
+            ++_ndiagnostics;
+        ErrorVeneer::account(level);
+    }
+    int ndiagnostics() const {
+        return _ndiagnostics;
+    }
+  private:
+    int _ndiagnostics;
+};
+}
+
+// Encodings parsed during this run, keyed by content digest, parse flags,
+// and number of glyph lists. Only parses without diagnostics are kept.
+static HashMap<String, int> parsed_encoding_map(-1);
+static Vector<DvipsEncoding *> parsed_encodings;
+
+bool
+DvipsEncoding::pristine() const
+{
+    return _e.size() == 0 && _lig.size() == 0 && _pos.size() == 0
+        && _unicoding.size() == 0 && _encoding_required.size() == 0
+        && _boundary_char < 0 && _altselector_char < 0
+        && !_coding_scheme && !_warn_missing;
+}
+
 int
 DvipsEncoding::parse(String filename, bool ignore_ligkern, bool ignore_other, ErrorHandler *errh)
 {
@@ -619,8 +754,51 @@ DvipsEncoding::parse(String filename, bool ignore_ligkern, bool ignore_other, Er
     String s = read_file(filename, errh);
     if (errh->nerrors() != before)
         return -1;
+
+    bool cacheable = pristine();
+    int flags = (ignore_ligkern ? 1 : 0) | (ignore_other ? 2 : 0);
+    MD5_CONTEXT md5;
+    unsigned char digest[MD5_DIGEST_SIZE];
+    md5_init(&md5);
+    md5_update(&md5, s.udata(), s.length());
+    md5_final(digest, &md5);
+    StringAccum keysa;
+    keysa.append((const char *) digest, MD5_DIGEST_SIZE);
+    String digest_str = keysa.take_string();
+    keysa << digest_str << flags << '/' << glyphlists.size();
+    String key = keysa.take_string();
+
+    String cache;
+    if (cacheable && filename && filename != "-")
+        cache = cache_filename(filename, flags);
+
+    int index = cacheable ? parsed_encoding_map[key] : -1;
+    if (index >= 0)
+        *this = *parsed_encodings[index];
+    else if (!cache || !read_cache(cache, filename, flags, digest_str)) {
+        _filename = filename;
+        _printable_filename = printable_filename(filename);
+        CountingErrorHandler cerrh(errh);
+        Vector<String> unicoding_text;
+        int r = parse_text(s, ignore_ligkern, ignore_other, &cerrh, &unicoding_text);
+        if (r < 0 || !cacheable || cerrh.ndiagnostics() != 0)
+            return r;
+        if (cache)
+            write_cache(cache, filename, flags, digest_str, unicoding_text);
+    }
+
     _filename = filename;
     _printable_filename = printable_filename(filename);
+    if (index < 0) {
+        parsed_encoding_map.insert(key, parsed_encodings.size());
+        parsed_encodings.push_back(new DvipsEncoding(*this));
+    }
+    return 0;
+}
+
+int
+DvipsEncoding::parse_text(const String &s, bool ignore_ligkern, bool ignore_other, ErrorHandler *errh, Vector<String> *unicoding_text)
+{
     _file_had_ligkern = false;
     int pos = 0, line = 1;
 
@@ -664,6 +842,8 @@ DvipsEncoding::parse(String filename, bool ignore_ligkern, bool ignore_other, Er
                    && !ignore_other) {
             lerrh.set_landmark(landmark(line));
             parse_words(token.substring(10), 1, WT_UNICODING, &lerrh);
+            if (unicoding_text)
+                unicoding_text->push_back(token.substring(10));
 
         } else if (token.length() >= 9
                    && memcmp(token.data(), "POSITION", 8) == 0
@@ -701,6 +881,137 @@ DvipsEncoding::parse(String filename, bool ignore_ligkern, bool ignore_other, Er
     return 0;
 }
 
+/* Compiled encoding cache. Each encoding file gets one file in
+   $XDG_CACHE_HOME/lcdf-typetools (default ~/.cache/lcdf-typetools):
+
+     "ENCIDX01" path size mtime flags digest
+     name coding_scheme initial_comment final_text
+     boundary_char altselector_char file_had_ligkern warn_missing
+     n { glyph_name } n { required } n { c1 c2 join k d } n { c1 c2 join k d }
+     n { unicoding_text }
+
+   The encoding is described in <lcdf/cachefile.hh>. The "digest" is the
+   MD5 of the encoding file's text. UNICODING directives depend on the glyph
+   lists, so their text is stored and reparsed when the cache is read.
+   Setting LCDF_TYPETOOLS_NOCACHE disables the cache. */
+
+static const char encoding_cache_magic[] = "ENCIDX01";
+
+String
+DvipsEncoding::cache_filename(const String &filename, int flags)
+{
+    // name the cache after the file name and flags
+    StringAccum sa;
+    sa << filename << (char) flags;
+    return ::cache_filename("enc-", sa.take_string());
+}
+
+bool
+DvipsEncoding::read_cache(const String &cache, const String &filename, int flags, const String &digest)
+{
+    CacheReader r;
+    if (!r.read(cache))
+        return false;
+
+    String str;
+    uint32_t w, n;
+    if (!r.get(str) || str != encoding_cache_magic
+        || !r.get(str) || str != filename
+        || !r.check_file_stamp(filename)
+        || !r.get(w) || w != (uint32_t) flags
+        || !r.get(str) || str != digest)
+        return false;
+
+    DvipsEncoding e;
+    uint32_t had_ligkern, warn_missing;
+    if (!r.get(e._name) || !r.get(e._coding_scheme)
+        || !r.get(e._initial_comment) || !r.get(e._final_text)
+        || !r.get(e._boundary_char) || !r.get(e._altselector_char)
+        || !r.get(had_ligkern) || !r.get(warn_missing)
+        || !r.get(n) || n > 0x10000)
+        return false;
+    e._file_had_ligkern = had_ligkern != 0;
+    e._warn_missing = warn_missing != 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (!r.get(str))
+            return false;
+        e._e.push_back(str);
+    }
+    if (!r.get(n) || n > 0x10000)
+        return false;
+    for (uint32_t i = 0; i < n; i++) {
+        if (!r.get(w))
+            return false;
+        e._encoding_required.push_back(w != 0);
+    }
+    for (int which = 0; which < 2; which++) {
+        Vector<Ligature> &v = (which ? e._pos : e._lig);
+        if (!r.get(n) || n > 0x100000)
+            return false;
+        for (uint32_t i = 0; i < n; i++) {
+            Ligature l;
+            if (!r.get(l.c1) || !r.get(l.c2) || !r.get(l.join)
+                || !r.get(l.k) || !r.get(l.d))
+                return false;
+            v.push_back(l);
+        }
+    }
+    if (!r.get(n) || n > 0x10000)
+        return false;
+    CountingErrorHandler cerrh(0);
+    for (uint32_t i = 0; i < n; i++) {
+        if (!r.get(str))
+            return false;
+        e.parse_words(str, 1, WT_UNICODING, &cerrh);
+    }
+    if (!r.done() || cerrh.ndiagnostics() != 0)
+        return false;
+    *this = e;
+    return true;
+}
+
+void
+DvipsEncoding::write_cache(const String &cache, const String &filename, int flags, const String &digest, const Vector<String> &unicoding_text) const
+{
+    CacheWriter w;
+    w.put(String(encoding_cache_magic));
+    w.put(filename);
+    if (!w.put_file_stamp(filename))
+        return;
+    w.put(flags);
+    w.put(digest);
+
+    w.put(_name);
+    w.put(_coding_scheme);
+    w.put(_initial_comment);
+    w.put(_final_text);
+    w.put(_boundary_char);
+    w.put(_altselector_char);
+    w.put(_file_had_ligkern);
+    w.put(_warn_missing);
+    w.put(_e.size());
+    for (int i = 0; i < _e.size(); i++)
+        w.put(String(_e[i]));
+    w.put(_encoding_required.size());
+    for (int i = 0; i < _encoding_required.size(); i++)
+        w.put(_encoding_required[i]);
+    for (int which = 0; which < 2; which++) {
+        const Vector<Ligature> &v = (which ? _pos : _lig);
+        w.put(v.size());
+        for (const Ligature *l = v.begin(); l != v.end(); l++) {
+            w.put(l->c1);
+            w.put(l->c2);
+            w.put(l->join);
+            w.put(l->k);
+            w.put(l->d);
+        }
+    }
+    w.put(unicoding_text.size());
+    for (int i = 0; i < unicoding_text.size(); i++)
+        w.put(unicoding_text[i]);
+    w.write(cache, true);
+}
+
 int
 DvipsEncoding::parse_ligkern(const String &ligkern_text, int override, ErrorHandler *errh)
 {
@@ -735,8 +1046,8 @@ DvipsEncoding::bad_codepoint(int code, Metrics &metrics, HashMap<PermString, int
         bool unicodes_explicit = x_unicodes(_e[code], garbage);
         if (!unicodes_explicit || garbage.size() > 0) {
             Vector<Setting> v;
-            v.push_back(Setting(Setting::RULE, 500, 500));
-            v.push_back(Setting(Setting::SPECIAL, String("Warning: missing glyph '") + _e[code] + "'"));
+            v.emplace_back(Setting::RULE, 500, 500);
+            v.emplace_back(Setting::SPECIAL, String("Warning: missing glyph '") + _e[code] + "'");
             metrics.encode_virtual(code, _e[code], 0, v, true);
             unencoded.insert(_e[code], 1);
         }
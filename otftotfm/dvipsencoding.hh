@@ -12,6 +12,7 @@ class DvipsEncoding { public:
     DvipsEncoding();
 
     static void add_glyphlist(String);
+    static bool add_glyphlist_database(const String &);
 
     operator bool() const                       { return _e.size() > 0; }
     const String &name() const                  { return _name; }
@@ -87,6 +88,11 @@ class DvipsEncoding { public:
 
     void add_ligkern(const Ligature &, int override);
     enum { EPARSE = 90000 };
+    int parse_text(const String &text, bool ignore_ligkern, bool ignore_other, ErrorHandler *, Vector<String> *unicoding_text);
+    bool pristine() const;
+    static String cache_filename(const String &filename, int flags);
+    bool read_cache(const String &cache, const String &filename, int flags, const String &digest);
+    void write_cache(const String &cache, const String &filename, int flags, const String &digest, const Vector<String> &unicoding_text) const;
     int parse_ligkern_words(Vector<String> &, int override, ErrorHandler *);
     int parse_position_words(Vector<String> &, int override, ErrorHandler *);
     int parse_unicoding_words(Vector<String> &, int override, ErrorHandler *);
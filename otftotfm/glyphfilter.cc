@@ -21,10 +21,68 @@
 #include <lcdf/error.hh>
 #include <lcdf/straccum.hh>
 #include <ctype.h>
+#include <string.h>
 #include <algorithm>
 #include "uniprop.hh"
 #include "util.hh"
 
+static int
+literal_prefix_length(const String& pattern)
+{
+    const char* meta = pattern.begin();
+    while (meta != pattern.end() && *meta != '*' && *meta != '?' && *meta != '[')
+        ++meta;
+    return meta - pattern.begin();
+}
+
+static bool
+name_match(const String& name, const String& pattern, int literal_prefix)
+{
+    if (literal_prefix == pattern.length())
+        return name == pattern;
+    else if (name.length() < literal_prefix
+             || memcmp(name.data(), pattern.data(), literal_prefix) != 0)
+        return false;
+    else
+        return glob_match(name, pattern);
+}
+
+void
+GlyphFilter::compile(const Vector<PermString>& glyph_names)
+{
+    int nglyphs = glyph_names.size();
+    int nwords = (nglyphs + 31) >> 5;
+    _compiled_nglyphs = nglyphs;
+    _compiled_words = nwords;
+
+    _name_bits.assign(_patterns.size() * nwords, 0);
+    for (int i = 0; i < _patterns.size(); ++i) {
+        const Pattern& p = _patterns[i];
+        if (p.data != D_NAME)
+            continue;
+        int literal_prefix = literal_prefix_length(p.pattern);
+        uint32_t* bits = _name_bits.begin() + i * nwords;
+        for (int g = 0; g < nglyphs; ++g)
+            if (name_match(glyph_names[g], p.pattern, literal_prefix))
+                bits[g >> 5] |= 1U << (g & 31);
+    }
+
+    for (int t = 0; t < 2; ++t) {
+        int ptype = t ? T_DST : T_SRC;
+        _verdict_bits[t].clear();
+        bool unicode_free = true;
+        for (const Pattern* p = _patterns.begin(); p < _patterns.end(); p++)
+            if ((p->type & ~T_TYPEMASK) == ptype && p->data != D_NAME)
+                unicode_free = false;
+        if (unicode_free) {
+            _verdict_bits[t].assign(nwords, 0);
+            for (int g = 0; g < nglyphs; ++g)
+                if (match_patterns(g, glyph_names, 0, ptype))
+                    _verdict_bits[t][g >> 5] |= 1U << (g & 31);
+        }
+    }
+}
+
 bool
 GlyphFilter::allow(Efont::OpenType::Glyph glyph, const Vector<PermString>& glyph_names, uint32_t unicode, int ptype) const
 {
@@ -32,7 +90,21 @@ GlyphFilter::allow(Efont::OpenType::Glyph glyph, const Vector<PermString>& glyph
     if (glyph < 0 || glyph >= glyph_names.size())
         return false;
 
-    String glyph_name = glyph_names[glyph];
+    // use the precomputed bitsets only if compile() saw this many glyphs
+    if (_compiled_nglyphs != glyph_names.size())
+        return match_patterns(glyph, glyph_names, unicode, ptype);
+
+    const Vector<uint32_t>& verdict = _verdict_bits[ptype == T_DST];
+    if (verdict.size())
+        return (verdict[glyph >> 5] & (1U << (glyph & 31))) != 0;
+    else
+        return match_patterns(glyph, glyph_names, unicode, ptype);
+}
+
+bool
+GlyphFilter::match_patterns(Efont::OpenType::Glyph glyph, const Vector<PermString>& glyph_names, uint32_t unicode, int ptype) const
+{
+    bool compiled = (_compiled_nglyphs == glyph_names.size());
     int uniprop = -1;
     bool any_includes = false;
     bool included = false;
@@ -50,8 +122,11 @@ GlyphFilter::allow(Efont::OpenType::Glyph glyph, const Vector<PermString>& glyph
         }
         // check if there's a match
         bool match;
-        if (p->data == D_NAME)
-            match = glob_match(glyph_name, p->pattern);
+        if (p->data == D_NAME && compiled) {
+            const uint32_t* bits = _name_bits.begin() + (p - _patterns.begin()) * _compiled_words;
+            match = (bits[glyph >> 5] & (1U << (glyph & 31))) != 0;
+        } else if (p->data == D_NAME)
+            match = name_match(glyph_names[glyph], p->pattern, literal_prefix_length(p->pattern));
         else if (p->data == D_UNIPROP) {
             if (uniprop < 0)
                 uniprop = UnicodeProperty::property(unicode);
@@ -97,6 +172,7 @@ void
 GlyphFilter::add_pattern(const String& pattern, int ptype, ErrorHandler* errh)
 {
     _sorted = false;
+    _compiled_nglyphs = -1;
 
     const char* begin = pattern.begin();
     const char* end = pattern.end();
@@ -173,6 +249,7 @@ GlyphFilter&
 GlyphFilter::operator+=(const GlyphFilter& gf)
 {
     // be careful about self-addition
+    _compiled_nglyphs = -1;
     _patterns.reserve(gf._patterns.size());
     const Pattern* end = gf._patterns.end();
     for (const Pattern* p = gf._patterns.begin(); p < end; p++)
@@ -215,6 +292,7 @@ GlyphFilter::sort()
         Pattern* true_end = std::unique(_patterns.begin(), _patterns.end());
         _patterns.erase(true_end, _patterns.end());
         _sorted = true;
+        _compiled_nglyphs = -1;
     }
 }
 
@@ -6,7 +6,7 @@ class Metrics;
 
 class GlyphFilter { public:
 
-    GlyphFilter()                       : _sorted(true) { }
+    GlyphFilter()                       : _sorted(true), _compiled_nglyphs(-1) { }
 
     operator bool() const               { return _patterns.size() != 0; }
 
@@ -23,6 +23,9 @@ class GlyphFilter { public:
 
     void unparse(StringAccum&) const;
 
+    // Precompute name matches for a font; call again for each new font.
+    void compile(const Vector<PermString>& glyph_names);
+
     struct Pattern {
         uint16_t type;
         uint16_t data;
@@ -50,7 +53,16 @@ class GlyphFilter { public:
     Vector<Pattern> _patterns;
     bool _sorted;
 
+    // compile() matches name patterns once per glyph of a font: _name_bits
+    // holds one glyph bitset per pattern. When a pattern type has no Unicode
+    // clauses, the whole verdict is precomputed in _verdict_bits.
+    int _compiled_nglyphs;
+    int _compiled_words;
+    Vector<uint32_t> _name_bits;
+    Vector<uint32_t> _verdict_bits[2];
+
     bool allow(Efont::OpenType::Glyph glyph, const Vector<PermString>& glyph_names, uint32_t unicode, int ptype) const;
+    bool match_patterns(Efont::OpenType::Glyph glyph, const Vector<PermString>& glyph_names, uint32_t unicode, int ptype) const;
     void add_pattern(const String&, int ptype, ErrorHandler*);
     void sort();
 
@@ -202,8 +202,8 @@ Metrics::apply_base_encoding(const String &font_name, const DvipsEncoding &dvips
                 font_number = add_mapped_font(mapped_font(0), font_name);
             VirtualChar *vc = c->virtual_char = new VirtualChar;
             vc->name = dvipsenc.encoding(mapping[c->glyph]);
-            vc->setting.push_back(Setting(Setting::FONT, font_number));
-            vc->setting.push_back(Setting(Setting::SHOW, mapping[c->glyph], c->glyph));
+            vc->setting.emplace_back(Setting::FONT, font_number);
+            vc->setting.emplace_back(Setting::SHOW, mapping[c->glyph], c->glyph);
             c->glyph = VIRTUAL_GLYPH;
             c->base_code = -1;
             c->flags = (c->flags & ~Char::BASE_LIVE) | Char::BASE_REP;
@@ -218,7 +218,7 @@ Metrics::add_altselector_code(Code code, int altselector_type)
             k->kern = altselector_type;
             return;
         }
-    _altselectors.push_back(Kern(code, altselector_type));
+    _altselectors.emplace_back(code, altselector_type);
 }
 
 bool
@@ -294,7 +294,7 @@ inline void
 Metrics::new_ligature(Code in1, Code in2, Code out)
 {
     assert(valid_code(in1) && valid_code(in2) && valid_code(out));
-    _encoding[in1].ligatures.push_back(Ligature(in2, out));
+    _encoding[in1].ligatures.emplace_back(in2, out);
 }
 
 inline void
@@ -332,7 +332,7 @@ Metrics::pair_code(Code in1, Code in2, int lookup_source)
         VirtualChar *vc = ch.virtual_char = new VirtualChar;
         vc->name = permprintf("%s__%s", code_str(in1), code_str(in2));
         setting(in1, vc->setting, SET_INTERMEDIATE);
-        vc->setting.push_back(Setting(Setting::KERN));
+        vc->setting.emplace_back(Setting::KERN);
         setting(in2, vc->setting, SET_INTERMEDIATE);
         ch.built_in1 = in1;
         ch.built_in2 = in2;
@@ -392,7 +392,7 @@ Metrics::add_kern(Code in1, Code in2, int kern)
     if (Kern *k = kern_obj(in1, in2))
         k->kern += kern;
     else
-        _encoding[in1].kerns.push_back(Kern(in2, kern));
+        _encoding[in1].kerns.emplace_back(in2, kern);
 }
 
 void
@@ -413,7 +413,7 @@ Metrics::set_kern(Code in1, Code in2, int kern)
             } else
                 k->kern = kern;
         } else if (kern != 0)
-            ch.kerns.push_back(Kern(in2, kern));
+            ch.kerns.emplace_back(in2, kern);
     }
 }
 
@@ -892,7 +892,7 @@ Metrics::all_ligatures(Vector<Ligature3> &all_ligs) const
     all_ligs.clear();
     for (Code code = 0; code < _encoding.size(); code++)
         for (const Ligature *l = _encoding[code].ligatures.begin(); l != _encoding[code].ligatures.end(); l++)
-            all_ligs.push_back(Ligature3(code, l->in2, l->out));
+            all_ligs.emplace_back(code, l->in2, l->out);
     std::sort(all_ligs.begin(), all_ligs.end());
 }
 
@@ -1193,30 +1193,61 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
                 && scores[l->out] > CONVENTIONAL_F_F_LIGATURE_SCORE)
                 scores[l->out] = CONVENTIONAL_F_F_LIGATURE_SCORE;
 
-    /* Repeat these steps until you reach a stable set of scores: Score
-       ligatures (ligscore = SUM[char scores]), then score characters touched
-       only by fakes. */
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (Ligature3 *l = all_ligs.begin(); l != all_ligs.end(); l++) {
-            int score = scores[l->in1] + scores[l->in2];
-            if (scores[l->out] > score)
-                scores[l->out] = score, changed = true;
-        }
+    /* Propagate scores until they are stable: a ligature scores the sum of
+       its inputs' scores, and the parts of a virtual character score less
+       than the character. Scores only decrease, so the result does not
+       depend on the order of updates; use a worklist over the graph from
+       each code to the ligatures it feeds. */
+    int ncodes = _encoding.size();
+    Vector<int> lig_first(ncodes + 1, 0);
+    for (Ligature3 *l = all_ligs.begin(); l != all_ligs.end(); l++) {
+        lig_first[l->in1]++;
+        if (l->in2 != l->in1)
+            lig_first[l->in2]++;
+    }
+    for (Code c = 0; c < ncodes; c++)
+        lig_first[c + 1] += lig_first[c];
+    Vector<int> lig_index(lig_first[ncodes], 0);
+    for (int i = all_ligs.size() - 1; i >= 0; i--) {
+        const Ligature3 &l = all_ligs[i];
+        lig_index[--lig_first[l.in1]] = i;
+        if (l.in2 != l.in1)
+            lig_index[--lig_first[l.in2]] = i;
+    }
 
-        for (Code c = 0; c < _encoding.size(); c++)
-            if (VirtualChar *vc = _encoding[c].virtual_char) {
-                /* Make sure that if this virtual character appears, its parts
-                   will also appear, by scoring the parts less */
-                int score = scores[c] - 1, font_number = 0;
-                for (Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
-                    if (s->op == Setting::SHOW && font_number == 0
-                        && score < scores[s->x])
-                        scores[s->x] = score, changed = true;
-                    else if (s->op == Setting::FONT)
-                        font_number = s->x;
+    Vector<Code> worklist;
+    Vector<char> queued(ncodes, 1);
+    for (Code c = ncodes - 1; c >= 0; c--)
+        worklist.push_back(c);
+    while (worklist.size()) {
+        Code c = worklist.back();
+        worklist.pop_back();
+        queued[c] = 0;
+
+        for (int *i = lig_index.begin() + lig_first[c];
+             i != lig_index.begin() + lig_first[c + 1]; i++) {
+            const Ligature3 &l = all_ligs[*i];
+            int score = scores[l.in1] + scores[l.in2];
+            if (scores[l.out] > score) {
+                scores[l.out] = score;
+                if (!queued[l.out])
+                    worklist.push_back(l.out), queued[l.out] = 1;
             }
+        }
+
+        if (VirtualChar *vc = _encoding[c].virtual_char) {
+            /* Make sure that if this virtual character appears, its parts
+               will also appear, by scoring the parts less */
+            int score = scores[c] - 1, font_number = 0;
+            for (Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
+                if (s->op == Setting::SHOW && font_number == 0
+                    && score < scores[s->x]) {
+                    scores[s->x] = score;
+                    if (!queued[s->x])
+                        worklist.push_back(s->x), queued[s->x] = 1;
+                } else if (s->op == Setting::FONT)
+                    font_number = s->x;
+        }
     }
 
     /* Rescore intermediates to not be better off than their endpoints. */
@@ -1261,8 +1292,11 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
                 && dvipsenc.encoded(c) == (bool) want_encoded)
                 empty_codes.push_back(c);
 
-    /* Then, assign codes to the unencoded characters. */
+    /* Then, assign codes to the unencoded characters. Once a search fails,
+       later searches with the same or stricter needs fail too, at least
+       until some character is assigned. */
     int nunencoded = 0;
+    bool needs_failed[4] = { false, false, false, false };
 
     for (Slot *slot = slots.begin(); slot != slots.end(); slot++) {
         if (slot->new_code >= 0)
@@ -1273,14 +1307,16 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
         assert(needs > 0);
 
         Code dest = -1;
-        for (Code *h = empty_codes.begin(); h < empty_codes.end() && dest < 0; h++) {
-            int haves = (_encoding[*h].base_code < 0 ? 1 : 0)
-                + (!_encoding[*h].visible() ? 2 : 0);
-            if ((needs & haves) == needs)
-                dest = *h;
-        }
+        if (!needs_failed[needs])
+            for (Code *h = empty_codes.begin(); h < empty_codes.end() && dest < 0; h++) {
+                int haves = (_encoding[*h].base_code < 0 ? 1 : 0)
+                    + (!_encoding[*h].visible() ? 2 : 0);
+                if ((needs & haves) == needs)
+                    dest = *h;
+            }
 
         if (dest >= 0) {
+            needs_failed[1] = needs_failed[2] = needs_failed[3] = false;
             if (needs & 2) {
                 assert(!_encoding[dest].visible());
                 _encoding[dest].swap(_encoding[slot->old_code]);
@@ -1293,8 +1329,12 @@ Metrics::shrink_encoding(int size, const DvipsEncoding &dvipsenc, ErrorHandler *
                 assert(_encoding[dest].base_code < 0 || _encoding[dest].base_code == slot->old_code);
                 _encoding[dest].base_code = slot->old_code;
             }
-        } else
+        } else {
+            for (int n = needs; n < 4; n++)
+                if ((n & needs) == needs)
+                    needs_failed[n] = true;
             nunencoded++;
+        }
     }
 
     /* Complain if some characters can't fit. */
@@ -1399,7 +1439,7 @@ Metrics::setting(Code code, Vector<Setting> &v, SettingMode sm) const
         int font_number = 0;
 
         if (ch.pdx != 0 || ch.pdy != 0)
-            v.push_back(Setting(Setting::MOVE, ch.pdx, ch.pdy));
+            v.emplace_back(Setting::MOVE, ch.pdx, ch.pdy);
 
         for (const Setting *s = vc->setting.begin(); s != vc->setting.end(); s++)
             switch (s->op) {
@@ -1432,23 +1472,23 @@ Metrics::setting(Code code, Vector<Setting> &v, SettingMode sm) const
                     if (s->op == Setting::KERNX)
                         k -= letterspace;
                     if (k)
-                        v.push_back(Setting(Setting::MOVE, k, 0));
+                        v.emplace_back(Setting::MOVE, k, 0);
                 }
                 break;
             }
 
         if (ch.pdy != 0 || ch.adx - ch.pdx != 0)
-            v.push_back(Setting(Setting::MOVE, ch.adx - ch.pdx, -ch.pdy));
+            v.emplace_back(Setting::MOVE, ch.adx - ch.pdx, -ch.pdy);
         return good;
 
     } else if (ch.base_code >= 0) {
         if (ch.pdx != 0 || ch.pdy != 0)
-            v.push_back(Setting(Setting::MOVE, ch.pdx, ch.pdy));
+            v.emplace_back(Setting::MOVE, ch.pdx, ch.pdy);
 
-        v.push_back(Setting(Setting::SHOW, ch.base_code, ch.glyph));
+        v.emplace_back(Setting::SHOW, ch.base_code, ch.glyph);
 
         if (ch.pdy != 0 || ch.adx - ch.pdx != 0)
-            v.push_back(Setting(Setting::MOVE, ch.adx - ch.pdx, -ch.pdy));
+            v.emplace_back(Setting::MOVE, ch.adx - ch.pdx, -ch.pdy);
         return true;
 
     } else
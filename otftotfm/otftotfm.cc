@@ -19,6 +19,7 @@
 # include <io.h>
 #endif
 #include <efont/psres.hh>
+#include <efont/fontindex.hh>
 #include <efont/t1rw.hh>
 #include <efont/t1font.hh>
 #include <efont/t1item.hh>
@@ -51,6 +52,7 @@
 #include <signal.h>
 #include <algorithm>
 #include <math.h>
+#include <sys/stat.h>
 /* M_PI isn't defined in C99 */
 #ifndef M_PI
 # define M_PI 3.14159265358979323846264338327
@@ -72,6 +74,7 @@ using namespace Efont;
 #define QUERY_SCRIPTS_OPT       303
 #define QUERY_FEATURES_OPT      304
 #define KPATHSEA_DEBUG_OPT      305
+#define LOOKUP_INDEX_OPT        306
 
 #define SCRIPT_OPT              311
 #define FEATURE_OPT             312
@@ -118,6 +121,7 @@ using namespace Efont;
 #define NOCREATE_OPT            356
 #define VERBOSE_OPT             357
 #define FORCE_OPT               358
+#define JSON_DIAGNOSTICS_OPT    359
 
 #define VIRTUAL_OPT             360
 #define PL_OPT                  361
@@ -226,9 +230,11 @@ static Clp_Option options[] = {
 
     { "quiet", 'q', QUIET_OPT, 0, Clp_Negate },
     { "glyphlist", 0, GLYPHLIST_OPT, Clp_ValString, 0 },
+    { "lookup-index", 0, LOOKUP_INDEX_OPT, Clp_ValString, 0 },
     { "no-create", 0, NOCREATE_OPT, 0, 0 },
     { "force", 0, FORCE_OPT, 0, Clp_Negate },
     { "verbose", 'V', VERBOSE_OPT, 0, Clp_Negate },
+    { "json-diagnostics", 0, JSON_DIAGNOSTICS_OPT, 0, 0 },
     { "kpathsea-debug", 0, KPATHSEA_DEBUG_OPT, Clp_ValInt, 0 },
 
     { "help", 'h', HELP_OPT, 0, 0 },
@@ -402,6 +408,8 @@ File location options:\n\
 \n\
 Other options:\n\
       --glyphlist=FILE         Use FILE to map Adobe glyph names to Unicode.\n\
+      --lookup-index=FILE      Look up FONT by PostScript name in font index\n\
+                               FILE (see otfinfo --build-index).\n\
   -V, --verbose                Print progress information to standard error.\n\
       --no-create              Print messages, don't modify any files.\n\
       --force                  Generate files even if versions already exist.\n"
@@ -410,6 +418,7 @@ Other options:\n\
 #endif
 "  -h, --help                   Print this message and exit.\n\
   -q, --quiet                  Do not generate any error messages.\n\
+      --json-diagnostics       Print error messages as JSON lines.\n\
       --version                Print version number and exit.\n\
 \n\
 Report bugs to <ekohler@gmail.com>.\n");
@@ -1406,6 +1415,19 @@ main_dvips_map(const String &ps_name, const FontInfo &finfo, ErrorHandler *errh)
     return "<" + pathname_filename(otf_filename);
 }
 
+static void
+compile_filters(Vector<Lookup>& lookups, const Vector<PermString>& glyph_names)
+{
+    // match each glyph filter against this font's glyph names once
+    Vector<GlyphFilter*> done;
+    for (Lookup* l = lookups.begin(); l != lookups.end(); ++l)
+        if (l->used && l->filter
+            && std::find(done.begin(), done.end(), l->filter) == done.end()) {
+            l->filter->compile(glyph_names);
+            done.push_back(l->filter);
+        }
+}
+
 static void
 do_gsub(Metrics& metrics, const OpenType::Font& otf,
         DvipsEncoding& dvipsenc, bool dvipsenc_literal,
@@ -1416,6 +1438,7 @@ do_gsub(Metrics& metrics, const OpenType::Font& otf,
     OpenType::Gsub gsub(otf.table("GSUB"), &otf, errh);
     Vector<Lookup> lookups(gsub.nlookups(), Lookup());
     find_lookups(gsub.script_list(), gsub.feature_list(), lookups, errh);
+    compile_filters(lookups, glyph_names);
 
     // find all characters that might result
     Vector<bool> used(glyph_names.size(), false);
@@ -1474,6 +1497,7 @@ do_gsub(Metrics& metrics, const OpenType::Font& otf,
         altselector_feature_filters.swap(feature_filters);
         Vector<Lookup> alt_lookups(gsub.nlookups(), Lookup());
         find_lookups(gsub.script_list(), gsub.feature_list(), alt_lookups, ErrorHandler::silent_handler());
+        compile_filters(alt_lookups, glyph_names);
         Vector<OpenType::Substitution> alt_subs;
         for (int i = 0; i < alt_lookups.size(); i++)
             if (alt_lookups[i].used) {
@@ -1840,6 +1864,31 @@ parse_base_encodings(const String &filename, ErrorHandler *errh)
     }
 }
 
+static void
+read_glyphlist(const String &filename, ErrorHandler *errh)
+{
+    // Prefer a compiled glyph list (see make-glyphlist-db.pl) at least as
+    // new as the text version: "glyphlist.txt" -> "glyphlist.db".
+    String db_filename = filename;
+    if (db_filename.length() > 4 && db_filename.substring(-4) == ".txt")
+        db_filename = db_filename.substring(0, -4);
+    db_filename += ".db";
+    struct stat st, db_st;
+    if (stat(db_filename.c_str(), &db_st) == 0
+        && (stat(filename.c_str(), &st) != 0 || db_st.st_mtime >= st.st_mtime)) {
+        SilentErrorHandler serrh;
+        if (DvipsEncoding::add_glyphlist_database(read_file(db_filename, &serrh))) {
+            if (verbose)
+                errh->message("using compiled glyphlist %s", db_filename.c_str());
+            return;
+        } else if (verbose)
+            errh->warning("%s: bad compiled glyphlist, ignoring", db_filename.c_str());
+    }
+
+    if (String s = read_file(filename, errh, true))
+        DvipsEncoding::add_glyphlist(s);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -1848,6 +1897,7 @@ main(int argc, char *argv[])
 #endif
     Clp_Parser *clp =
         Clp_NewParser(argc, (const char * const *)argv, sizeof(options) / sizeof(options[0]), options);
+    Clp_SetResponseFiles(clp, 1);
     Clp_AddType(clp, CHAR_OPTTYPE, 0, clp_parse_char, 0);
     program_name = Clp_ProgramName(clp);
 #if HAVE_KPATHSEA
@@ -1865,6 +1915,7 @@ main(int argc, char *argv[])
 
     ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, String(program_name) + ": "));
     const char *input_file = 0;
+    const char *index_file = 0;
     Vector<String> glyphlist_files;
     bool literal_encoding = false;
     bool have_encoding_file = false;
@@ -1874,6 +1925,7 @@ main(int argc, char *argv[])
     Vector<String> base_encoding_files;
     bool no_ecommand = false, default_ligkern = true;
     int warn_missing = -1;
+    bool json_diagnostics = false;
     unsigned specified_output_flags = 0;
     String codingscheme;
     const char* odirs[NUMODIR + 1];
@@ -2231,6 +2283,16 @@ main(int argc, char *argv[])
             verbose = !clp->negated;
             break;
 
+          case LOOKUP_INDEX_OPT:
+            index_file = clp->vstr;
+            break;
+
+          case JSON_DIAGNOSTICS_OPT:
+            errh = new JsonErrorHandler(stderr, program_name);
+            ErrorHandler::set_default_handler(errh);
+            json_diagnostics = true;
+            break;
+
           case NOCREATE_OPT:
             no_create = clp->negated;
             break;
@@ -2310,6 +2372,17 @@ particular purpose.\n");
     // set up file names
     if (!input_file)
         usage_error(errh, "no font filename provided");
+    String indexed_input_file;
+    if (index_file) {
+        FontIndex index;
+        if (!index.read(index_file, errh))
+            exit(1);
+        int i = index.find_postscript_name(input_file);
+        if (i >= 0) {
+            indexed_input_file = index[i].filename;
+            input_file = indexed_input_file.c_str();
+        }
+    }
     if (encoding_file == "-")
         encoding_file = "";
 
@@ -2380,8 +2453,7 @@ particular purpose.\n");
 
         // read glyphlist
         for (String *g = glyphlist_files.begin(); g < glyphlist_files.end(); g++)
-            if (String s = read_file(*g, errh, true))
-                DvipsEncoding::add_glyphlist(s);
+            read_glyphlist(*g, errh);
 
         // read base encodings
         for (String *s = base_encoding_files.begin(); s < base_encoding_files.end(); s++)
@@ -2435,7 +2507,12 @@ particular purpose.\n");
         if (warn_missing >= 0)
             dvipsenc.set_warn_missing(warn_missing);
 
-        do_file(input_file, otf, dvipsenc, literal_encoding, errh);
+        if (json_diagnostics) {
+            // report each distinct message once, with a repeat count
+            BufferedErrorHandler berrh(errh, true);
+            do_file(input_file, otf, dvipsenc, literal_encoding, &berrh);
+        } else
+            do_file(input_file, otf, dvipsenc, literal_encoding, errh);
 
     } catch (OpenType::Error e) {
         errh->error("unhandled exception %<%s%>", e.description.c_str());
@@ -86,7 +86,8 @@ enum {
 
 FontInfo::FontInfo(const Efont::OpenType::Font *otf_, ErrorHandler *errh)
     : otf(otf_), cmap(0), cff_file(0), cff(0), post(0), name(0), _nglyphs(-1),
-      _got_glyph_names(false), _ttb_program(0), _override_is_fixed_pitch(false),
+      _got_glyph_names(false), _ttb_program(0),
+      _override_is_fixed_pitch(false),
       _override_italic_angle(false), _override_x_height(x_height_auto)
 {
     cmap = new Efont::OpenType::Cmap(otf->table("cmap"), errh);
@@ -186,11 +187,20 @@ FontInfo::program() const
         return cff;
     else {
         if (!_ttb_program)
-            _ttb_program = new Efont::TrueTypeBoundsCharstringProgram(otf);
+            _ttb_program = new Efont::TrueTypeCharstringProgram(otf);
         return _ttb_program;
     }
 }
 
+bool
+FontInfo::glyph_bounds(int gid, const Transform &transform,
+                       double bounds[4], double &width) const
+{
+    // TrueType bounds also come from the outline, so they agree with the
+    // character dimensions in the metrics files, with or without shear.
+    return Efont::CharstringBounds::bounds(transform, program(), gid, bounds, width);
+}
+
 bool
 FontInfo::is_fixed_pitch() const
 {
@@ -327,8 +337,8 @@ SettingSet& SettingSet::show(int uni) {
         if (!v_.empty()
             && v_.back().op == Setting::SHOW
             && kern_type_)
-            v_.push_back(Setting(kern_type_));
-        v_.push_back(Setting(Setting::SHOW, code, metrics_.base_glyph(code)));
+            v_.emplace_back(kern_type_);
+        v_.emplace_back(Setting::SHOW, code, metrics_.base_glyph(code));
     }
     return *this;
 }
@@ -656,7 +666,7 @@ char_bounds(double bounds[4], double& width, const FontInfo &finfo,
             const Transform &transform, uint32_t uni)
 {
     if (Efont::OpenType::Glyph g = finfo.cmap->map_uni(uni))
-        return Efont::CharstringBounds::bounds(transform, finfo.program()->glyph_context(g), bounds, width);
+        return finfo.glyph_bounds(g, transform, bounds, width);
     else
         return false;
 }
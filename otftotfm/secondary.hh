@@ -6,7 +6,7 @@
 class Metrics;
 class Secondary;
 class Transform;
-namespace Efont { class TrueTypeBoundsCharstringProgram; }
+namespace Efont { class TrueTypeCharstringProgram; }
 
 struct FontInfo {
 
@@ -28,6 +28,8 @@ struct FontInfo {
     bool glyph_names(Vector<PermString> &) const;
     int glyphid(PermString) const;
     const Efont::CharstringProgram *program() const;
+    bool glyph_bounds(int gid, const Transform &, double bounds[4],
+                      double &width) const;
     int units_per_em() const {
         return program()->units_per_em();
     }
@@ -60,7 +62,7 @@ struct FontInfo {
     mutable Vector<PermString> _glyph_names;
     mutable bool _got_glyph_names;
     mutable Vector<uint32_t> _unicodes;
-    mutable Efont::TrueTypeBoundsCharstringProgram *_ttb_program;
+    mutable Efont::TrueTypeCharstringProgram *_ttb_program;
     bool _override_is_fixed_pitch;
     bool _override_italic_angle;
     bool _is_fixed_pitch;
@@ -139,7 +141,7 @@ inline SettingSet& SettingSet::kernx(bool is_kernx) {
 
 inline SettingSet& SettingSet::push_back(Setting s) {
     if (ok_)
-        v_.push_back(s);
+        v_.push_back(std::move(s));
     return *this;
 }
 
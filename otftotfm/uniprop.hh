@@ -20,15 +20,6 @@ class UnicodeProperty { public:
     static const char* property_name(int p);
     static bool parse_property(const String&, int& prop, int& prop_mask);
 
-  private:
-
-    enum { P_Lul = 070 };
-    static const unsigned char property_pages[];
-    static const unsigned int property_offsets[];
-    static const int nproperty_offsets;
-
-    static inline const unsigned int* find_offset(uint32_t uni);
-
 };
 
 #endif
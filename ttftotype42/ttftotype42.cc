@@ -33,6 +33,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
+#include <algorithm>
 #ifdef HAVE_CTIME
 # include <time.h>
 #endif
@@ -118,13 +119,106 @@ static const NameId fontinfo_names[] = {
     { 0, 0 }
 };
 
+static const uint8_t zero_pad[4] = { 0, 0, 0, 0 };
+
+// Writes PostScript hex strings through a fixed-size output buffer.
+class HexStringWriter { public:
+    HexStringWriter(FILE *f)            : _f(f), _x(_buf), _col(0), _len(0) { }
+    ~HexStringWriter()                  { flush(); }
+
+    void open();
+    void append(const uint8_t *s, uint32_t len);
+    void append_table(const String &table, uint32_t begin, uint32_t end);
+    void close();
+
+  private:
+    enum { LINE = 38 };
+    FILE *_f;
+    char *_x;
+    int _col;
+    uint32_t _len;
+    char _buf[8192];
+
+    void reserve(int n) {
+        if (_x + n > _buf + sizeof(_buf))
+            flush();
+    }
+    void flush() {
+        fwrite(_buf, 1, _x - _buf, _f);
+        _x = _buf;
+    }
+};
+
+void
+HexStringWriter::open()
+{
+    reserve(1);
+    *_x++ = '<';
+    _col = 0;
+    _len = 0;
+}
+
+void
+HexStringWriter::append(const uint8_t *s, uint32_t len)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    const uint8_t *end = s + len;
+    while (s < end) {
+        if (_col == LINE) {
+            reserve(1);
+            *_x++ = '\n';
+            _col = 0;
+        }
+        int n = (end - s < LINE - _col ? end - s : LINE - _col);
+        reserve(2 * n);
+        for (int i = 0; i < n; i++, s++, _x += 2) {
+            _x[0] = hex[*s >> 4];
+            _x[1] = hex[*s & 0xF];
+        }
+        _col += n;
+    }
+    _len += len;
+}
+
+// Append table bytes [begin, end), treating the table as zero-padded to a
+// multiple of 4 bytes.
+void
+HexStringWriter::append_table(const String &table, uint32_t begin, uint32_t end)
+{
+    uint32_t len = table.length();
+    if (begin < len) {
+        append(table.udata() + begin, (end < len ? end : len) - begin);
+        begin = len;
+    }
+    if (begin < end)
+        append(zero_pad, end - begin);
+}
+
+void
+HexStringWriter::close()
+{
+    reserve(5);
+    if (_col == LINE || _len == 0)
+        *_x++ = '\n';
+    memcpy(_x, "00>\n", 4);
+    _x += 4;
+}
+
+static inline uint32_t
+padded_length(const String &table)
+{
+    return (table.length() + 3) & ~3;
+}
+
 static void
-fprint_sfnts(FILE *f, const String &data, bool glyf, const OpenType::Font &font)
+fprint_sfnts(HexStringWriter &w, const String &table, uint32_t begin, uint32_t end, bool glyf, const OpenType::Font &font)
 {
+    uint32_t length = end - begin;
     OpenType::Data head = font.table("head");
     bool loca_long = (head.length() >= 52 && head.u16(50) != 0);
     // Do not split fonts with long offsets -- Werner Lemberg
-    if (glyf && data.length() >= 65535 && !loca_long) {
+    if (glyf && length >= 65535 && !loca_long) {
+        // split only at glyph boundaries
         OpenType::Data loca = font.table("loca");
         int loca_size = (loca_long ? 4 : 2);
         uint32_t first_offset = 0;
@@ -132,31 +226,25 @@ fprint_sfnts(FILE *f, const String &data, bool glyf, const OpenType::Font &font)
             uint32_t next_offset = (loca_long ? loca.u32(4*i) : loca.u16(2*i) * 2);
             if (next_offset - first_offset >= 65535) {
                 uint32_t prev_offset = (loca_long ? loca.u32(4*i - 4) : loca.u16(2*i - 2) * 2);
-                fprint_sfnts(f, data.substring(first_offset, prev_offset - first_offset), false, font);
+                uint32_t a = std::min(first_offset, length);
+                uint32_t b = std::min(prev_offset, length);
+                fprint_sfnts(w, table, begin + a, begin + std::max(a, b), false, font);
                 first_offset = prev_offset;
             }
         }
-        fprint_sfnts(f, data.substring(first_offset), false, font);
-    } else if (data.length() >= 65535) {
-        for (int offset = 0; offset < data.length(); ) {
-            int next_offset = offset + 65534;
-            if (next_offset > data.length())
-                next_offset = data.length();
-            fprint_sfnts(f, data.substring(offset, next_offset - offset), false, font);
+        fprint_sfnts(w, table, begin + std::min(first_offset, length), end, false, font);
+    } else if (length >= 65535) {
+        for (uint32_t offset = begin; offset < end; ) {
+            uint32_t next_offset = offset + 65534;
+            if (next_offset > end)
+                next_offset = end;
+            fprint_sfnts(w, table, offset, next_offset, false, font);
             offset = next_offset;
         }
     } else {
-        fputc('<', f);
-        const uint8_t *s = data.udata();
-        for (int i = 0; i < data.length(); i++) {
-            if (i && (i % 38) == 0)
-                fputc('\n', f);
-            fputc("0123456789ABCDEF"[(s[i] >> 4) & 0xF], f);
-            fputc("0123456789ABCDEF"[s[i] & 0xF], f);
-        }
-        if ((data.length() % 38) == 0)
-            fputc('\n', f);
-        fputs("00>\n", f);
+        w.open();
+        w.append_table(table, begin, end);
+        w.close();
     }
 }
 
@@ -205,7 +293,8 @@ do_file(const char *infn, const char *outfn, ErrorHandler *errh)
     if (!otf.table("glyf") || head_data.length() <= 52 || !name.ok())
         cerrh.fatal("font appears to lack required tables");
 
-    // create reduced font
+    // create reduced font; only its table directory is built in memory,
+    // the tables themselves are streamed from the input font
     Vector<OpenType::Tag> tags;
     Vector<String> tables;
     for (const char * const *table = t42_tables; *table; table++)
@@ -213,7 +302,25 @@ do_file(const char *infn, const char *outfn, ErrorHandler *errh)
             tags.push_back(*table);
             tables.push_back(s);
         }
-    OpenType::Font reduced_font = OpenType::Font::make(true, tags, tables);
+    Vector<int> order;
+    String directory = OpenType::Font::make_directory(true, tags, tables, &order);
+    OpenType::Data dir(directory);
+
+    // fix 'head' checksum adjustment, which covers the whole reduced font
+    {
+        uint32_t allsum = OpenType::Font::checksum(directory);
+        for (int i = 0; i < order.size(); i++)
+            allsum += dir.u32(OpenType::Font::HEADER_SIZE + OpenType::Font::TABLE_DIR_ENTRY_SIZE * i + 4);
+        for (int i = 0; i < tags.size(); i++)
+            if (tags[i] == OpenType::Tag("head") && tables[i].length() >= 12) {
+                char *x = tables[i].mutable_data();
+                uint32_t adj = 0xB1B0AFBA - allsum;
+                x[8] = adj >> 24;
+                x[9] = adj >> 16;
+                x[10] = adj >> 8;
+                x[11] = adj;
+            }
+    }
 
     // output file
     if (!outfn || strcmp(outfn, "-") == 0) {
@@ -254,7 +361,12 @@ do_file(const char *infn, const char *outfn, ErrorHandler *errh)
     {
         MD5_CONTEXT md5;
         md5_init(&md5);
-        md5_update(&md5, (const unsigned char *) reduced_font.data(), reduced_font.length());
+        md5_update(&md5, dir.udata(), dir.length());
+        for (int *tp = order.begin(); tp != order.end(); ++tp) {
+            const String &t = tables[*tp];
+            md5_update(&md5, t.udata(), t.length());
+            md5_update(&md5, zero_pad, padded_length(t) - t.length());
+        }
         unsigned char result[MD5_DIGEST_SIZE + 3];
         memset(result, 0, sizeof(result));
         md5_final(result, &md5);
@@ -294,14 +406,12 @@ do_file(const char *infn, const char *outfn, ErrorHandler *errh)
     fprintf(f, "readonly def\n");
 
     // print 'sfnts' array
-    OpenType::Data sfnts = reduced_font.data_string();
     fprintf(f, "/sfnts[\n");
-    fprint_sfnts(f, sfnts.substring(0, OpenType::Font::HEADER_SIZE + OpenType::Font::TABLE_DIR_ENTRY_SIZE * reduced_font.ntables()), false, reduced_font);
-    for (int i = 0; i < reduced_font.ntables(); i++) {
-        int off = OpenType::Font::HEADER_SIZE + OpenType::Font::TABLE_DIR_ENTRY_SIZE * i;
-        uint32_t offset = sfnts.u32(off + 8);
-        uint32_t length = (sfnts.u32(off + 12) + 3) & ~3;
-        fprint_sfnts(f, sfnts.substring(offset, length), sfnts.u32(off) == 0x676C7966 /*glyf*/, reduced_font);
+    {
+        HexStringWriter w(f);
+        fprint_sfnts(w, directory, 0, directory.length(), false, otf);
+        for (int *tp = order.begin(); tp != order.end(); ++tp)
+            fprint_sfnts(w, tables[*tp], 0, padded_length(tables[*tp]), tags[*tp] == OpenType::Tag("glyf"), otf);
     }
     fprintf(f, "] def\n");
 